@@ -0,0 +1,93 @@
+// File: archiver.cpp
+// Owner: Team
+// Role: Archiver Command-Line Tool
+// Description: Bundles relocatable .o files into a static library (.a) with a symbol
+//              index, and lists an existing library.
+//              Usage: archiver -o libstd.a math.o io.o ...
+//                     archiver -t libstd.a
+
+#include "archive.h"
+#include "thread_pool.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int list_archive(const std::string &path) {
+    auto file = std::make_shared<const MappedFile>(MappedFile::open_read(path));
+    Archive archive = Archive::from_mapping(file, path);
+    std::vector<std::vector<std::string_view>> defined(archive.member_count());
+    for (const auto &symbol : archive.symbols()) {
+        defined[symbol.second].push_back(symbol.first);
+    }
+    for (uint32_t m = 0; m < archive.member_count(); m++) {
+        std::cout << archive.member_name(m) << ":";
+        for (std::string_view name : defined[m]) std::cout << " " << name;
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> inputs;
+    std::string output, list;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-o" || arg == "-t") && i + 1 >= argc) {
+            inputs.clear();
+            output.clear();
+            break;
+        }
+        if (arg == "-o") {
+            output = argv[++i];
+        } else if (arg == "-t") {
+            list = argv[++i];
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (list.empty() && (inputs.empty() || output.empty())) {
+        std::cerr << "Usage: " << argv[0] << " -o <output.a> <input.o>..." << std::endl;
+        std::cerr << "       " << argv[0] << " -t <library.a>    (list members and the symbols they define)" << std::endl;
+        return 1;
+    }
+
+    try {
+        if (!list.empty()) {
+            return list_archive(list);
+        }
+
+        std::vector<ParsedObjectFile> objects(inputs.size());
+        std::vector<std::string> names(inputs.size()), errors(inputs.size());
+        ThreadPool pool;
+        pool.parallel_for(inputs.size(), [&](size_t i) {
+            try {
+                objects[i] = ParsedObjectFile::from_file(inputs[i]);
+                names[i] = fs::path(inputs[i]).filename().string();
+            } catch (const std::exception &e) {
+                errors[i] = e.what();
+            }
+        });
+        for (const auto &error : errors) {
+            if (!error.empty()) throw std::runtime_error(error);
+        }
+
+        std::vector<uint8_t> archive = build_archive(objects, names);
+        std::error_code ec;
+        fs::remove(output, ec);
+        std::ofstream out(output, std::ios::binary);
+        if (!out.write(reinterpret_cast<const char *>(archive.data()), archive.size())) {
+            throw std::runtime_error("Cannot write " + output);
+        }
+        std::cout << "Archived " << objects.size() << " object(s) into '" << output << "' (" << archive.size()
+                  << " bytes)." << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "❌ Archive failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+// File: asmclient.cpp
+// Owner: Team
+// Role: Assembler Server Client
+// Description: Sends one assembly request to `assembler --serve` and writes the object it
+//              returns. A drop-in replacement for `assembler <input> <output>` in builds:
+//              Usage: asmclient [--socket PATH] [-O] [--verify] <input.stkasm> <output.o>
+//                     asmclient [--socket PATH] --shutdown
+
+#include "serve_protocol.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+static void print_usage(const char *prog) {
+    std::fprintf(stderr,
+                 "Usage: %s [--socket PATH] [-O] [--verify] <input.stkasm> <output.o>\n"
+                 "       %s [--socket PATH] --shutdown\n"
+                 "       The socket defaults to $STKASM_SOCKET. Use '-' as the input to send\n"
+                 "       the source from stdin instead of its path.\n",
+                 prog, prog);
+}
+
+static bool read_stdin(std::vector<uint8_t> &source) {
+    uint8_t chunk[1 << 16];
+    for (;;) {
+        ssize_t n = ::read(STDIN_FILENO, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) return true;
+        source.insert(source.end(), chunk, chunk + n);
+    }
+}
+
+static bool write_output(const std::string &path, const uint8_t *data, size_t length) {
+    ::unlink(path.c_str()); // Replace rather than overwrite, like the assembler does.
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    while (length > 0) {
+        ssize_t n = ::write(fd, data, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ::close(fd);
+            return false;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+    }
+    return ::close(fd) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    std::string socket_path;
+    if (const char *env = std::getenv("STKASM_SOCKET")) {
+        socket_path = env;
+    }
+    uint8_t flags = 0;
+    bool shutdown = false;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "-O") {
+            flags |= SERVE_FLAG_OPTIMIZE;
+        } else if (arg == "--verify") {
+            flags |= SERVE_FLAG_VERIFY;
+        } else if (arg == "--shutdown") {
+            shutdown = true;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (socket_path.empty() || (shutdown ? !files.empty() : files.size() != 2)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    ServeRequest kind = ServeRequest::SHUTDOWN;
+    std::vector<uint8_t> source;
+    std::string path;
+    if (!shutdown) {
+        if (files[0] == "-") {
+            kind = ServeRequest::SOURCE;
+            if (!read_stdin(source)) {
+                std::fprintf(stderr, "❌ Cannot read stdin: %s\n", std::strerror(errno));
+                return 1;
+            }
+        } else {
+            // The server resolves paths against its own working directory.
+            kind = ServeRequest::PATH;
+            std::error_code ec;
+            path = std::filesystem::absolute(files[0], ec).string();
+            if (ec) path = files[0];
+        }
+    }
+
+    int fd;
+    try {
+        fd = connect_unix(socket_path);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "❌ %s\n", e.what());
+        return 1;
+    }
+    if (fd < 0) {
+        std::fprintf(stderr, "❌ Cannot connect to the assembler server at '%s': %s\n", socket_path.c_str(),
+                     std::strerror(errno));
+        return 1;
+    }
+
+    uint8_t head[2] = {static_cast<uint8_t>(kind), flags};
+    const void *payload = kind == ServeRequest::SOURCE ? static_cast<const void *>(source.data()) : path.data();
+    size_t payload_length = kind == ServeRequest::SOURCE ? source.size() : path.size();
+    std::vector<uint8_t> response;
+    bool answered = false;
+    try {
+        answered = send_frame(fd, head, sizeof(head), payload, payload_length) && receive_frame(fd, response);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "❌ %s\n", e.what());
+    }
+    ::close(fd);
+    if (!answered || response.empty()) {
+        std::fprintf(stderr, "❌ The assembler server closed the connection without answering.\n");
+        return 1;
+    }
+
+    if (static_cast<ServeStatus>(response[0]) != ServeStatus::OK) {
+        std::fprintf(stderr, "❌ Assembly failed: %.*s\n", static_cast<int>(response.size() - 1),
+                     reinterpret_cast<const char *>(response.data() + 1));
+        return 1;
+    }
+    if (!shutdown && !write_output(files[1], response.data() + 1, response.size() - 1)) {
+        std::fprintf(stderr, "❌ Cannot write '%s': %s\n", files[1].c_str(), std::strerror(errno));
+        return 1;
+    }
+    return 0;
+}
@@ -1,47 +1,346 @@
-#include "parser.h"
-#include "emitter.h"
+#include "driver.h"
+#include "arg_parse.h"
+#include "cache.h"
+#include "server.h"
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
-#include <fstream>
+#include <memory>
+#include <filesystem>
+#include <string>
 #include <vector>
 
+namespace fs = std::filesystem;
+
+static void print_usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " <input_file.stkasm> <output_file.vm>" << std::endl;
+    std::cerr << "       " << prog << " [-j N] <input.stkasm>... -o <output_dir/>" << std::endl;
+    std::cerr << "       Use '-' as the input file to read the source from stdin." << std::endl;
+    std::cerr << "       -O optimizes: folds constants, fuses superinstructions, removes redundant jumps." << std::endl;
+    std::cerr << "       --verify rejects code that can underflow the operand stack or reach a label at" << std::endl;
+    std::cerr << "       different stack depths, and reports each function's proven maximum depth." << std::endl;
+    std::cerr << "       -j N assembles up to N files in parallel, or splits a single large file" << std::endl;
+    std::cerr << "       across N threads (default: one per core)." << std::endl;
+    std::cerr << "       --cache-dir DIR   reuse objects for unchanged sources (or set STKASM_CACHE_DIR)" << std::endl;
+    std::cerr << "       --cache-size N    cache size limit in bytes, K/M/G suffixes allowed (default 512M)" << std::endl;
+    std::cerr << "       --cache-stats     print cache statistics" << std::endl;
+    std::cerr << "       --stats[=json]    report time, CPU and allocations per phase, peak RSS and throughput" << std::endl;
+    std::cerr << "                         (with =json, stdout holds only the JSON; other output goes to stderr)" << std::endl;
+    std::cerr << "       " << prog << " [-j N] --serve <socket>" << std::endl;
+    std::cerr << "       Serves requests from asmclient on a Unix socket until SIGINT/SIGTERM" << std::endl;
+    std::cerr << "       or `asmclient --shutdown`, keeping assembled objects cached in memory." << std::endl;
+}
+
+// Parses sizes such as "4096", "64K", "512M" or "2G"; returns false on any
+// other text or a size that does not fit in 64 bits.
+static bool parse_size(const std::string &text, uint64_t &size) {
+    const char *end = text.data() + text.size();
+    uint64_t value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (ec != std::errc() || ptr == text.data()) return false;
+    unsigned shift = 0;
+    if (ptr < end) {
+        switch (*ptr++) {
+            case 'k': case 'K': shift = 10; break;
+            case 'm': case 'M': shift = 20; break;
+            case 'g': case 'G': shift = 30; break;
+            default: return false;
+        }
+    }
+    if (ptr != end || value > (UINT64_MAX >> shift)) return false;
+    size = value << shift;
+    return true;
+}
+
+static void print_cache_stats(const AssemblyCache &cache, uint64_t max_bytes, std::ostream &out) {
+    AssemblyCache::Stats stats = cache.stats();
+    uint64_t lookups = stats.hits + stats.misses;
+    out << "Cache: " << stats.entries << " entries, " << stats.bytes << " / " << max_bytes << " bytes; "
+              << "this run " << cache.run_hits() << " hits, " << cache.run_misses() << " misses; "
+              << "lifetime " << stats.hits << " hits, " << stats.misses << " misses";
+    if (lookups) {
+        out << " (" << (100 * stats.hits / lookups) << "% hit rate)";
+    }
+    out << "." << std::endl;
+}
+
+enum class StatsFormat { NONE, TEXT, JSON };
+
+// With --stats=json stdout carries only the JSON report; everything else goes to stderr.
+static std::ostream &report_stream(StatsFormat format) {
+    return format == StatsFormat::JSON ? std::cerr : std::cout;
+}
+
+// Prints the --stats report. For a batch, `stats` is summed over its files;
+// `cached_files` of them were reused from the cache and only cost the write.
+static void print_stats(const AssemblyStats &stats, size_t files, size_t cached_files,
+                        const AssemblerOptions &options, StatsFormat format) {
+    PhaseCounters total = stats.total();
+    double lines_per_sec = total.wall_seconds > 0 ? stats.lines / total.wall_seconds : 0;
+    double bytes_per_sec = total.wall_seconds > 0 ? stats.source_bytes / total.wall_seconds : 0;
+    long rss_kb = peak_rss_kb();
+
+    if (format == StatsFormat::JSON) {
+        std::printf("{\n  \"files\": %zu,\n  \"cached_files\": %zu,\n  \"phases\": {\n", files, cached_files);
+        for (size_t i = 0; i < PHASE_COUNT; i++) {
+            const PhaseCounters &p = stats.phases[i];
+            std::printf("    \"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"allocations\": %llu, "
+                        "\"allocated_bytes\": %llu}%s\n",
+                        phase_name(static_cast<Phase>(i)), p.wall_seconds * 1e3, p.cpu_seconds * 1e3,
+                        static_cast<unsigned long long>(p.allocations),
+                        static_cast<unsigned long long>(p.allocated_bytes), i + 1 < PHASE_COUNT ? "," : "");
+        }
+        std::printf("  },\n  \"total\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"allocations\": %llu, "
+                    "\"allocated_bytes\": %llu},\n",
+                    total.wall_seconds * 1e3, total.cpu_seconds * 1e3,
+                    static_cast<unsigned long long>(total.allocations),
+                    static_cast<unsigned long long>(total.allocated_bytes));
+        std::printf("  \"lines\": %llu,\n  \"source_bytes\": %llu,\n  \"lines_per_sec\": %.0f,\n"
+                    "  \"bytes_per_sec\": %.0f,\n  \"peak_rss_kb\": %ld\n}\n",
+                    static_cast<unsigned long long>(stats.lines),
+                    static_cast<unsigned long long>(stats.source_bytes), lines_per_sec, bytes_per_sec, rss_kb);
+        return;
+    }
+
+    std::printf("%-10s %10s %10s %12s %14s\n", "Phase", "wall ms", "cpu ms", "allocations", "alloc bytes");
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        Phase phase = static_cast<Phase>(i);
+        if ((phase == Phase::OPTIMIZE && !options.optimize) || (phase == Phase::VERIFY && !options.verify)) {
+            continue;
+        }
+        const PhaseCounters &p = stats.phases[i];
+        std::printf("%-10s %10.3f %10.3f %12llu %14llu\n", phase_name(phase), p.wall_seconds * 1e3,
+                    p.cpu_seconds * 1e3, static_cast<unsigned long long>(p.allocations),
+                    static_cast<unsigned long long>(p.allocated_bytes));
+    }
+    std::printf("%-10s %10.3f %10.3f %12llu %14llu\n", "total", total.wall_seconds * 1e3, total.cpu_seconds * 1e3,
+                static_cast<unsigned long long>(total.allocations),
+                static_cast<unsigned long long>(total.allocated_bytes));
+    std::printf("Throughput: %llu lines, %llu bytes in %zu file(s): %.0f lines/s, %.1f MB/s. Peak RSS: %ld KB.\n",
+                static_cast<unsigned long long>(stats.lines), static_cast<unsigned long long>(stats.source_bytes),
+                files, lines_per_sec, bytes_per_sec / 1e6, rss_kb);
+    if (cached_files > 0) {
+        std::printf("Cache hits: %zu of %zu file(s) were reused from the cache.\n", cached_files, files);
+    }
+}
+
+static int run(const std::vector<std::string> &inputs, const std::string &output, unsigned jobs,
+               const AssemblerOptions &options, StatsFormat stats_format);
+
+static int run_server(const std::string &socket_path, unsigned jobs) {
+    ServerOptions options;
+    options.jobs = jobs;
+    try {
+        std::cout << "Serving on '" << socket_path << "'..." << std::endl;
+        ServerStats stats = serve(socket_path, options);
+        std::cout << "Served " << stats.requests << " requests (" << stats.memo_hits << " from memory, "
+                  << stats.errors << " failed)." << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "❌ Server failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <input_file.stkasm> <output_file.vm>" << std::endl;
+    std::vector<std::string> inputs;
+    std::string output;
+    unsigned jobs = 0;
+    bool have_output_flag = false;
+    std::string cache_dir;
+    uint64_t cache_size = 512ULL << 20;
+    bool cache_stats = false;
+    bool optimize = false;
+    bool verify = false;
+    StatsFormat stats_format = StatsFormat::NONE;
+    std::string serve_socket;
+    if (const char *env = std::getenv("STKASM_CACHE_DIR")) {
+        cache_dir = env;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-j" || arg == "-o" || arg == "--cache-dir" || arg == "--cache-size" || arg == "--serve") &&
+            i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (arg == "--cache-dir") {
+            cache_dir = argv[++i];
+        } else if (arg == "--cache-size") {
+            if (!parse_size(argv[++i], cache_size)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--serve") {
+            serve_socket = argv[++i];
+        } else if (arg == "--cache-stats") {
+            cache_stats = true;
+        } else if (arg == "--stats") {
+            stats_format = StatsFormat::TEXT;
+        } else if (arg == "--stats=json") {
+            stats_format = StatsFormat::JSON;
+        } else if (arg == "-O") {
+            optimize = true;
+        } else if (arg == "--verify") {
+            verify = true;
+        } else if (arg.rfind("-j", 0) == 0) {
+            if (!parse_number(arg == "-j" ? std::string_view(argv[++i]) : std::string_view(arg).substr(2), jobs)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "-o") {
+            output = argv[++i];
+            have_output_flag = true;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (!serve_socket.empty()) {
+        return run_server(serve_socket, jobs);
+    }
+
+    std::unique_ptr<AssemblyCache> cache;
+    AssemblerOptions options;
+    options.optimize = optimize;
+    options.verify = verify;
+    options.collect_stats = stats_format != StatsFormat::NONE;
+    options.file_jobs = jobs;
+    if (!cache_dir.empty()) {
+        cache = std::make_unique<AssemblyCache>(cache_dir, cache_size);
+        options.cache = cache.get();
+    }
+    if (cache_stats && inputs.empty() && !have_output_flag) {
+        if (!cache) {
+            std::cerr << "❌ --cache-stats needs --cache-dir or STKASM_CACHE_DIR." << std::endl;
+            return 1;
+        }
+        print_cache_stats(*cache, cache_size, std::cout);
+        return 0;
+    }
+
+    // Classic form: assembler <input> <output>
+    if (!have_output_flag && inputs.size() == 2) {
+        output = inputs.back();
+        inputs.pop_back();
+    }
+    if (inputs.empty() || output.empty()) {
+        print_usage(argv[0]);
         return 1;
     }
 
-    std::string input_file = argv[1];
-    std::string output_file = argv[2];
-    
-    std::cout << "Assembling '" << input_file << "' -> '" << output_file << "'..." << std::endl;
+    int status = run(inputs, output, jobs, options, stats_format);
+    if (cache) {
+        cache->finish();
+        if (cache_stats) {
+            print_cache_stats(*cache, cache_size, report_stream(stats_format));
+        }
+    }
+    return status;
+}
+
+// Assembles the inputs and prints a report; returns the process exit status.
+static int run(const std::vector<std::string> &inputs, const std::string &output, unsigned jobs,
+               const AssemblerOptions &options, StatsFormat stats_format) {
+    std::ostream &out = report_stream(stats_format);
 
-    try {
-        // Step 1: Parse the input file
-        AssemblyUnit unit = parse_file(input_file);
-        std::cout << "Parsing successful: Found " 
-                  << unit.instructions.size() << " instructions, "
-                  << unit.symbol_table.size() << " symbols, "
-                  << unit.data_entries.size() << " data entries." 
+    bool single_file = inputs.size() == 1 && !fs::is_directory(output) && output.back() != '/';
+    if (single_file) {
+        std::string input_file = inputs[0];
+        out << "Assembling '" << input_file << "' -> '" << output << "'..." << std::endl;
+
+        AssemblyResult result = assemble_file(input_file, output, options);
+        if (!result.ok) {
+            std::cerr << "❌ Assembly failed: " << result.error << std::endl;
+            return 1;
+        }
+        if (result.cached) {
+            out << "Cache hit: reused " << result.bytes << " bytes." << std::endl;
+            out << "✅ Assembly complete." << std::endl;
+            if (stats_format != StatsFormat::NONE) {
+                out.flush();
+                print_stats(result.stats, 1, 1, options, stats_format);
+            }
+            return 0;
+        }
+        out << "Parsing successful: Found "
+                  << result.instructions << " instructions, "
+                  << result.symbols << " symbols, "
+                  << result.data_entries << " data entries."
                   << std::endl;
+        if (result.optimized) {
+            const OptimizerStats &opt = result.optimizer;
+            out << "Optimization removed " << opt.instructions_removed() << " of "
+                      << opt.instructions_before << " instructions and " << opt.bytes_removed() << " of "
+                      << opt.bytes_before << " code bytes (" << opt.constants_folded << " constants folded, "
+                      << opt.superinstructions << " superinstructions, " << opt.jumps_removed
+                      << " jumps removed, " << opt.chains_collapsed << " jump chains collapsed)." << std::endl;
+        }
+        if (options.verify) {
+            out << "Stack verification successful: " << result.verified_functions
+                      << " functions, max depth " << result.max_stack_depth << "." << std::endl;
+        }
+        out << "Bytecode emission successful: Generated "
+                  << result.bytes << " bytes." << std::endl;
+        out << "✅ Assembly complete." << std::endl;
+        if (stats_format != StatsFormat::NONE) {
+            out.flush();
+            print_stats(result.stats, 1, 0, options, stats_format);
+        }
+        return 0;
+    }
 
-        // Step 2: Emit object file (bytecode)
-        std::vector<uint8_t> bytecode = emit_object_file(unit);
-        std::cout << "Bytecode emission successful: Generated " 
-                  << bytecode.size() << " bytes." << std::endl;
-        
-        // Step 3: Write to file
-        std::ofstream outfile(output_file, std::ios::binary);
-        if (!outfile) {
-            throw std::runtime_error("Cannot open output file for writing.");
-        }
-        outfile.write(reinterpret_cast<const char*>(bytecode.data()), bytecode.size());
-        
-        std::cout << "✅ Assembly complete." << std::endl;
-
-    } catch (const std::runtime_error& e) {
+    // Batch form: every input is assembled into the output directory on a thread pool.
+    for (const auto &input : inputs) {
+        if (input == "-") {
+            std::cerr << "❌ stdin ('-') can only be assembled on its own." << std::endl;
+            return 1;
+        }
+    }
+    std::vector<AssemblyResult> results;
+    try {
+        fs::create_directories(output);
+        results = assemble_files(inputs, output, jobs, options);
+    } catch (const std::exception &e) {
         std::cerr << "❌ Assembly failed: " << e.what() << std::endl;
         return 1;
     }
 
+    int failed = 0;
+    for (const auto &result : results) {
+        if (result.ok) {
+            out << "Assembled '" << result.input << "' -> '" << result.output << "': ";
+            if (result.cached) {
+                out << "cached, " << result.bytes << " bytes." << std::endl;
+            } else {
+                out << result.instructions << " instructions, " << result.bytes << " bytes";
+                if (result.optimized) {
+                    out << " (-O removed " << result.optimizer.instructions_removed() << " instructions, "
+                              << result.optimizer.bytes_removed() << " bytes)";
+                }
+                out << "." << std::endl;
+            }
+        } else {
+            std::cerr << "❌ " << result.input << ": " << result.error << std::endl;
+            failed++;
+        }
+    }
+    if (failed) {
+        std::cerr << "❌ " << failed << " of " << results.size() << " files failed to assemble." << std::endl;
+        return 1;
+    }
+    out << "✅ Assembled " << results.size() << " files." << std::endl;
+    if (stats_format != StatsFormat::NONE) {
+        AssemblyStats sum;
+        size_t cached = 0;
+        for (const auto &result : results) {
+            sum.merge(result.stats);
+            cached += result.cached;
+        }
+        out.flush();
+        print_stats(sum, results.size(), cached, options, stats_format);
+    }
     return 0;
 }
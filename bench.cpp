@@ -0,0 +1,284 @@
+// File: bench.cpp
+// Owner: Team
+// Role: Benchmark Harness
+// Description: Times parse_file, emit_object_file and the object file write
+//              separately over generated workloads and reports median/p99 and
+//              throughput, optionally as JSON for tracking regressions.
+//              Usage: benchmark [options]
+
+#include "parser.h"
+#include "arg_parse.h"
+#include "emitter.h"
+#include "workload.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct Workload
+{
+    std::string name;
+    WorkloadShape shape;
+};
+
+struct PhaseStats
+{
+    double median_ms = 0;
+    double p99_ms = 0;
+    double mb_per_s = 0; // Bytes processed by the phase, at the median time.
+};
+
+struct BenchResult
+{
+    Workload workload;
+    size_t source_bytes = 0;
+    size_t object_bytes = 0;
+    PhaseStats parse, emit, write;
+};
+
+static void print_usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [options]" << std::endl;
+    std::cerr << "  Runs the standard suite unless a shape option is given." << std::endl;
+    std::cerr << "  --instructions N      instructions per program" << std::endl;
+    std::cerr << "  --label-density F     labels per instruction" << std::endl;
+    std::cerr << "  --branch-ratio F      fraction of jmp/invoke instructions" << std::endl;
+    std::cerr << "  --forward-ratio F     fraction of branches to labels defined later" << std::endl;
+    std::cerr << "  --global-ratio F      fraction of labels declared .global" << std::endl;
+    std::cerr << "  --data N              .static entries" << std::endl;
+    std::cerr << "  --seed N              generator seed" << std::endl;
+    std::cerr << "  --iterations N        timed runs per phase (default 20)" << std::endl;
+    std::cerr << "  --json FILE           also write the results as JSON" << std::endl;
+    std::cerr << "  --label TEXT          tag stored in the JSON, e.g. a commit id" << std::endl;
+    std::cerr << "  --write-source FILE   write the generated program and exit" << std::endl;
+}
+
+static std::vector<Workload> standard_suite() {
+    std::vector<Workload> suite;
+    WorkloadShape shape;
+    shape.instructions = 10000;
+    suite.push_back({"small", shape});
+    shape.instructions = 200000;
+    suite.push_back({"medium", shape});
+    shape.instructions = 1000000;
+    suite.push_back({"large", shape});
+    shape = WorkloadShape();
+    shape.instructions = 200000;
+    shape.label_density = 0.5;
+    shape.global_ratio = 0.5;
+    suite.push_back({"label-heavy", shape});
+    shape = WorkloadShape();
+    shape.instructions = 200000;
+    shape.branch_ratio = 0.5;
+    shape.forward_ratio = 1.0;
+    suite.push_back({"forward-heavy", shape});
+    shape = WorkloadShape();
+    shape.instructions = 50000;
+    shape.data_entries = 100000;
+    suite.push_back({"data-heavy", shape});
+    return suite;
+}
+
+static PhaseStats summarize(std::vector<double> &seconds, size_t bytes) {
+    std::sort(seconds.begin(), seconds.end());
+    PhaseStats stats;
+    double median = seconds[seconds.size() / 2];
+    size_t p99_index = std::min(seconds.size() - 1, static_cast<size_t>(seconds.size() * 0.99));
+    stats.median_ms = median * 1e3;
+    stats.p99_ms = seconds[p99_index] * 1e3;
+    stats.mb_per_s = median > 0 ? bytes / median / 1e6 : 0;
+    return stats;
+}
+
+static double elapsed(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static BenchResult run_workload(const Workload &workload, unsigned iterations, const fs::path &dir) {
+    BenchResult result;
+    result.workload = workload;
+    std::string source = generate_workload(workload.shape);
+    result.source_bytes = source.size();
+    fs::path source_path = dir / (workload.name + ".stkasm");
+    fs::path object_path = dir / (workload.name + ".o");
+    {
+        std::ofstream out(source_path, std::ios::binary);
+        out << source;
+        if (!out) {
+            throw std::runtime_error("Cannot write " + source_path.string());
+        }
+    }
+
+    std::vector<double> parse_times, emit_times, write_times;
+    for (unsigned i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        AssemblyUnit unit = parse_file(source_path.string());
+        parse_times.push_back(elapsed(start));
+
+        start = Clock::now();
+        std::vector<uint8_t> bytecode = emit_object_file(unit);
+        emit_times.push_back(elapsed(start));
+        result.object_bytes = bytecode.size();
+
+        start = Clock::now();
+        {
+            std::ofstream out(object_path, std::ios::binary);
+            out.write(reinterpret_cast<const char *>(bytecode.data()), bytecode.size());
+        }
+        write_times.push_back(elapsed(start));
+    }
+    result.parse = summarize(parse_times, result.source_bytes);
+    result.emit = summarize(emit_times, result.object_bytes);
+    result.write = summarize(write_times, result.object_bytes);
+    return result;
+}
+
+static void write_phase_json(std::ostream &out, const char *name, const PhaseStats &stats, bool last) {
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "        \"%s\": {\"median_ms\": %.4f, \"p99_ms\": %.4f, \"mb_per_s\": %.2f}%s\n",
+                  name, stats.median_ms, stats.p99_ms, stats.mb_per_s, last ? "" : ",");
+    out << buf;
+}
+
+// `text` as a quoted JSON string.
+static std::string json_string(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+static void write_json(std::ostream &out, const std::vector<BenchResult> &results, const std::string &label,
+                       unsigned iterations) {
+    out << "{\n  \"label\": " << json_string(label) << ",\n  \"iterations\": " << iterations << ",\n  \"workloads\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        const WorkloadShape &s = r.workload.shape;
+        out << "    {\n      \"name\": \"" << r.workload.name << "\",\n"
+            << "      \"shape\": {\"instructions\": " << s.instructions << ", \"label_density\": " << s.label_density
+            << ", \"branch_ratio\": " << s.branch_ratio << ", \"forward_ratio\": " << s.forward_ratio
+            << ", \"global_ratio\": " << s.global_ratio << ", \"data_entries\": " << s.data_entries
+            << ", \"seed\": " << s.seed << "},\n"
+            << "      \"source_bytes\": " << r.source_bytes << ",\n"
+            << "      \"object_bytes\": " << r.object_bytes << ",\n"
+            << "      \"phases\": {\n";
+        write_phase_json(out, "parse", r.parse, false);
+        write_phase_json(out, "emit", r.emit, false);
+        write_phase_json(out, "write", r.write, true);
+        out << "      }\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    WorkloadShape shape;
+    bool custom_shape = false;
+    unsigned iterations = 20;
+    std::string json_path, label, source_path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0 || i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        bool valid = true; // Cleared by a numeric option whose value does not parse.
+        if (arg == "--instructions") {
+            valid = parse_number(value, shape.instructions);
+            custom_shape = true;
+        } else if (arg == "--label-density") {
+            valid = parse_number(value, shape.label_density);
+            custom_shape = true;
+        } else if (arg == "--branch-ratio") {
+            valid = parse_number(value, shape.branch_ratio);
+            custom_shape = true;
+        } else if (arg == "--forward-ratio") {
+            valid = parse_number(value, shape.forward_ratio);
+            custom_shape = true;
+        } else if (arg == "--global-ratio") {
+            valid = parse_number(value, shape.global_ratio);
+            custom_shape = true;
+        } else if (arg == "--data") {
+            valid = parse_number(value, shape.data_entries);
+            custom_shape = true;
+        } else if (arg == "--seed") {
+            valid = parse_number(value, shape.seed);
+            custom_shape = true;
+        } else if (arg == "--iterations") {
+            valid = parse_number(value, iterations);
+        } else if (arg == "--json") {
+            json_path = value;
+        } else if (arg == "--label") {
+            label = value;
+        } else if (arg == "--write-source") {
+            source_path = value;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations == 0 || shape.instructions == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (!source_path.empty()) {
+        std::ofstream out(source_path, std::ios::binary);
+        out << generate_workload(shape);
+        return out ? 0 : 1;
+    }
+
+    std::vector<Workload> workloads = custom_shape ? std::vector<Workload>{{"custom", shape}} : standard_suite();
+    fs::path dir = fs::temp_directory_path() / ("stkasm-bench-" + std::to_string(getpid()));
+    std::vector<BenchResult> results;
+    try {
+        fs::create_directories(dir);
+        std::printf("%-14s %10s %10s %10s %9s %10s %10s %9s %10s %10s %9s\n", "workload", "instrs",
+                    "parse(ms)", "p99", "MB/s", "emit(ms)", "p99", "MB/s", "write(ms)", "p99", "MB/s");
+        for (const Workload &workload : workloads) {
+            BenchResult r = run_workload(workload, iterations, dir);
+            std::printf("%-14s %10zu %10.3f %10.3f %9.1f %10.3f %10.3f %9.1f %10.3f %10.3f %9.1f\n",
+                        workload.name.c_str(), workload.shape.instructions, r.parse.median_ms, r.parse.p99_ms,
+                        r.parse.mb_per_s, r.emit.median_ms, r.emit.p99_ms, r.emit.mb_per_s, r.write.median_ms,
+                        r.write.p99_ms, r.write.mb_per_s);
+            results.push_back(r);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "❌ Benchmark failed: " << e.what() << std::endl;
+        fs::remove_all(dir);
+        return 1;
+    }
+    fs::remove_all(dir);
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        write_json(out, results, label, iterations);
+        if (!out) {
+            std::cerr << "❌ Cannot write " << json_path << std::endl;
+            return 1;
+        }
+        std::cout << "Results written to " << json_path << std::endl;
+    }
+    return 0;
+}
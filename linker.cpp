@@ -0,0 +1,105 @@
+// File: linker.cpp
+// Owner: Rashmitha
+// Role: Linker Command-Line Tool
+// Description: Links relocatable .o files and .a archives into a runnable .vm file.
+//              Usage: linker main.o math.o -o program.vm
+//                     linker main.o libstd.a -o program.vm
+//                     linker --gc [--keep sym]... [--print-gc] main.o lib.o -o program.vm
+//                     linker --symbols main.o lib.o -o program.vm   (also writes program.vm.sym)
+//                     linker --pic main.o lib.o -o program.vm       (position-independent image)
+
+#include "linker.h"
+#include "arg_parse.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> inputs;
+    std::string output;
+    LinkOptions options;
+    bool print_gc = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-o" || arg == "-j" || arg == "-e" || arg == "--keep") && i + 1 >= argc) {
+            inputs.clear();
+            break;
+        }
+        if (arg == "-o") {
+            output = argv[++i];
+        } else if (arg.rfind("-j", 0) == 0) {
+            if (!parse_number(arg == "-j" ? std::string_view(argv[++i]) : std::string_view(arg).substr(2),
+                              options.jobs)) {
+                inputs.clear();
+                break;
+            }
+        } else if (arg == "--incremental" || arg == "-i") {
+            options.incremental = true;
+        } else if (arg == "-e") {
+            options.entry = argv[++i];
+        } else if (arg == "--gc") {
+            options.gc = true;
+        } else if (arg == "--keep") {
+            options.keep.push_back(argv[++i]);
+        } else if (arg == "--print-gc") {
+            print_gc = true;
+        } else if (arg == "--symbols") {
+            options.symbols = true;
+        } else if (arg == "--pic") {
+            options.pic = true;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty() || output.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-j N] [-e entry] [--incremental] <input.o|lib.a>... -o <output.vm>" << std::endl;
+        std::cerr << "       " << argv[0] << " --gc [--keep symbol]... [--print-gc] <input.o>... -o <output.vm>" << std::endl;
+        std::cerr << "       --gc drops functions and .static data the entry point cannot reach; --keep adds" << std::endl;
+        std::cerr << "       roots and --print-gc lists what was removed." << std::endl;
+        std::cerr << "       --symbols also writes <output.vm>.sym, the symbol names `vm --profile` reports." << std::endl;
+        std::cerr << "       --pic writes a position-independent image the VM maps and runs in place." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Linking " << inputs.size() << " object file(s) -> '" << output << "'..." << std::endl;
+    try {
+        LinkResult result = link_objects(inputs, output, options);
+        if (result.incremental) {
+            std::cout << "Incremental link: rewrote " << result.objects_relinked << " of "
+                      << result.objects << " objects." << std::endl;
+        } else if (!result.fallback_reason.empty()) {
+            std::cout << "Full link (" << result.fallback_reason << ")." << std::endl;
+        }
+        if (result.archives > 0) {
+            std::cout << "Loaded " << result.members_loaded << " of " << result.archive_members << " member(s) from "
+                      << result.archives << " archive(s)." << std::endl;
+        }
+        if (result.gc) {
+            const GcReport &gc = result.removed;
+            std::cout << "GC removed " << gc.functions_removed << " of " << gc.functions << " functions ("
+                      << gc.code_bytes_removed << " code bytes) and " << gc.data_entries_removed << " of "
+                      << gc.data_entries << " data entries (" << gc.data_bytes_removed << " bytes)." << std::endl;
+            if (print_gc) {
+                for (const GcRemoved &removed : gc.removed) {
+                    std::printf("  removed %-4s %8u bytes  %s (%s)\n", removed.code ? "code" : "data", removed.bytes,
+                                removed.name.c_str(), removed.object.c_str());
+                }
+                std::fflush(stdout);
+            }
+        }
+        if (result.pic) {
+            std::cout << "Position-independent image: " << result.pic_records
+                      << " instruction records in page-aligned segments." << std::endl;
+        }
+        std::cout << "Resolved " << result.relocations << " relocations; code "
+                  << result.code_size << " bytes, data " << result.data_size
+                  << " bytes, entry point " << result.entry_point << "." << std::endl;
+        std::cout << "✅ Link complete." << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "❌ Link failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+// File: alloc_hook.cpp
+// Owner: Team
+// Role: Assembler Instrumentation
+// Description: Replacement global operator new/delete that count the calling
+//              thread's allocations while a PhaseTimer is running. The default
+//              array and nothrow forms forward here.
+
+#include "stats.h"
+#include <cstdlib>
+#include <new>
+
+void *operator new(std::size_t size) {
+    AllocationCounters &counters = thread_allocations;
+    if (counters.enabled) {
+        counters.count++;
+        counters.bytes += size;
+    }
+    if (size == 0) {
+        size = 1;
+    }
+    for (;;) {
+        if (void *p = std::malloc(size)) {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
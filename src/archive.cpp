@@ -0,0 +1,208 @@
+// File: archive.cpp
+// Owner: Team
+// Role: Static Libraries
+// Description: Reading and building STAR archives. The reader works on the mapped
+//              file in place; lookups touch only the index and the names it probes.
+
+#include "archive.h"
+#include "byte_io.h"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+// 32-bit FNV-1a over the symbol name, as in the symbol table.
+static uint32_t hash_name(std::string_view name) {
+    uint32_t h = 2166136261u;
+    for (unsigned char c : name) {
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint64_t align4(uint64_t size) {
+    return (size + 3) & ~uint64_t(3);
+}
+
+bool Archive::is_archive(const uint8_t *data, size_t size) {
+    return size >= 4 && read_u32(data) == STAR_MAGIC;
+}
+
+Archive Archive::from_mapping(std::shared_ptr<const MappedFile> file, const std::string &path) {
+    const uint8_t *data = file->data();
+    uint64_t size = file->size();
+    if (size < STAR_HEADER_SIZE || read_u32(data) != STAR_MAGIC) {
+        throw std::runtime_error("Not a STAR archive: " + path);
+    }
+    if (read_u32(data + star::VERSION) != STAR_VERSION) {
+        throw std::runtime_error("Unsupported STAR version " + std::to_string(read_u32(data + star::VERSION)) +
+                                 ": " + path);
+    }
+    auto section = [&](uint32_t offset_field, uint64_t length) {
+        uint32_t offset = read_u32(data + offset_field);
+        if (offset % 4 != 0 || offset + length > size) {
+            throw std::runtime_error("Section outside the file: " + path);
+        }
+        return data + offset;
+    };
+
+    Archive archive;
+    archive.file_path = path;
+    archive.members = read_u32(data + star::MEMBER_COUNT);
+    archive.slots = read_u32(data + star::SLOT_COUNT);
+    if ((archive.slots & (archive.slots - 1)) != 0) {
+        throw std::runtime_error("Index size is not a power of two: " + path);
+    }
+    archive.member_table = section(star::MEMBERS_OFFSET, static_cast<uint64_t>(archive.members) * STAR_MEMBER_SIZE);
+    archive.index = section(star::INDEX_OFFSET, static_cast<uint64_t>(archive.slots) * STAR_SLOT_SIZE);
+    archive.strings_size = read_u32(data + star::STRINGS_SIZE);
+    archive.strings = reinterpret_cast<const char *>(section(star::STRINGS_OFFSET, archive.strings_size));
+    archive.file = std::move(file);
+    return archive;
+}
+
+// The name a member or slot record points at: offset, then length.
+std::string_view Archive::string_at(const uint8_t *record) const {
+    uint32_t offset = read_u32(record);
+    uint32_t length = read_u32(record + 4);
+    if (static_cast<uint64_t>(offset) + length > strings_size) {
+        throw std::runtime_error("Invalid name in " + file_path);
+    }
+    return std::string_view(strings + offset, length);
+}
+
+std::string_view Archive::member_name(uint32_t member) const {
+    return string_at(member_table + member * STAR_MEMBER_SIZE);
+}
+
+uint32_t Archive::find(std::string_view symbol) const {
+    if (slots == 0) {
+        return NO_MEMBER;
+    }
+    uint32_t h = hash_name(symbol);
+    uint32_t mask = slots - 1;
+    for (uint32_t probes = 0, i = h & mask; probes < slots; probes++, i = (i + 1) & mask) {
+        const uint8_t *slot = index + i * STAR_SLOT_SIZE;
+        uint32_t member = read_u32(slot + 12);
+        if (member == STAR_EMPTY_SLOT) {
+            break;
+        }
+        if (read_u32(slot) == h && string_at(slot + 4) == symbol) {
+            if (member >= members) {
+                throw std::runtime_error("Index entry for '" + std::string(symbol) + "' names a missing member in " +
+                                         file_path);
+            }
+            return member;
+        }
+    }
+    return NO_MEMBER;
+}
+
+ParsedObjectFile Archive::load_member(uint32_t member) const {
+    const uint8_t *record = member_table + member * STAR_MEMBER_SIZE;
+    std::string name = file_path + "(" + std::string(member_name(member)) + ")";
+    uint32_t offset = read_u32(record + 8);
+    uint32_t size = read_u32(record + 12);
+    if (static_cast<uint64_t>(offset) + size > file->size()) {
+        throw std::runtime_error("Member outside the file: " + name);
+    }
+    return ParsedObjectFile::from_mapping(file, offset, size, name);
+}
+
+std::vector<std::pair<std::string_view, uint32_t>> Archive::symbols() const {
+    std::vector<std::pair<std::string_view, uint32_t>> result;
+    for (uint32_t i = 0; i < slots; i++) {
+        const uint8_t *slot = index + i * STAR_SLOT_SIZE;
+        uint32_t member = read_u32(slot + 12);
+        if (member != STAR_EMPTY_SLOT) {
+            result.push_back({string_at(slot + 4), member});
+        }
+    }
+    return result;
+}
+
+std::vector<uint8_t> build_archive(const std::vector<ParsedObjectFile> &objects,
+                                   const std::vector<std::string> &names) {
+    // 1. Collect every exported definition, rejecting duplicates.
+    std::vector<std::pair<std::string_view, uint32_t>> exported;
+    std::unordered_map<std::string_view, uint32_t> defined_by;
+    for (uint32_t m = 0; m < objects.size(); m++) {
+        for (const auto &sym : objects[m].symbol_table) {
+            if (sym.binding != Symbol::Binding::GLOBAL || sym.type == Symbol::Type::EXTERN) {
+                continue;
+            }
+            auto inserted = defined_by.emplace(sym.name, m);
+            if (!inserted.second) {
+                throw std::runtime_error("Global symbol '" + std::string(sym.name) + "' is defined by both " +
+                                         names[inserted.first->second] + " and " + names[m]);
+            }
+            exported.push_back({sym.name, m});
+        }
+    }
+
+    // 2. Size every section. The index is kept at most half full.
+    uint32_t slot_count = 1;
+    while (slot_count < exported.size() * 2) {
+        slot_count *= 2;
+    }
+    uint64_t strings_size = 0;
+    for (const auto &name : names) strings_size += name.size();
+    for (const auto &symbol : exported) strings_size += symbol.first.size();
+
+    uint64_t members_offset = STAR_HEADER_SIZE;
+    uint64_t index_offset = members_offset + static_cast<uint64_t>(objects.size()) * STAR_MEMBER_SIZE;
+    uint64_t strings_offset = index_offset + static_cast<uint64_t>(slot_count) * STAR_SLOT_SIZE;
+    uint64_t total = align4(strings_offset + strings_size);
+    std::vector<uint64_t> object_offsets(objects.size());
+    for (size_t m = 0; m < objects.size(); m++) {
+        object_offsets[m] = total;
+        total = align4(total + objects[m].file_size());
+        if (total > UINT32_MAX) {
+            throw std::runtime_error("Archive exceeds 4 GiB.");
+        }
+    }
+
+    // 3. Write it.
+    std::vector<uint8_t> archive(total);
+    uint8_t *out = archive.data();
+    write_u32(out, STAR_MAGIC);
+    write_u32(out + star::VERSION, STAR_VERSION);
+    write_u32(out + star::MEMBER_COUNT, static_cast<uint32_t>(objects.size()));
+    write_u32(out + star::MEMBERS_OFFSET, static_cast<uint32_t>(members_offset));
+    write_u32(out + star::SLOT_COUNT, slot_count);
+    write_u32(out + star::INDEX_OFFSET, static_cast<uint32_t>(index_offset));
+    write_u32(out + star::STRINGS_OFFSET, static_cast<uint32_t>(strings_offset));
+    write_u32(out + star::STRINGS_SIZE, static_cast<uint32_t>(strings_size));
+
+    uint32_t string_pos = 0;
+    auto add_string = [&](std::string_view s, uint8_t *record) {
+        std::copy(s.begin(), s.end(), out + strings_offset + string_pos);
+        write_u32(record, string_pos);
+        write_u32(record + 4, static_cast<uint32_t>(s.size()));
+        string_pos += static_cast<uint32_t>(s.size());
+    };
+    for (size_t m = 0; m < objects.size(); m++) {
+        uint8_t *record = out + members_offset + m * STAR_MEMBER_SIZE;
+        add_string(names[m], record);
+        write_u32(record + 8, static_cast<uint32_t>(object_offsets[m]));
+        write_u32(record + 12, static_cast<uint32_t>(objects[m].file_size()));
+        std::copy(objects[m].file_data(), objects[m].file_data() + objects[m].file_size(), out + object_offsets[m]);
+    }
+
+    uint8_t *index = out + index_offset;
+    for (uint32_t i = 0; i < slot_count; i++) {
+        write_u32(index + i * STAR_SLOT_SIZE + 12, STAR_EMPTY_SLOT);
+    }
+    for (const auto &symbol : exported) {
+        uint32_t h = hash_name(symbol.first);
+        uint32_t i = h & (slot_count - 1);
+        while (read_u32(index + i * STAR_SLOT_SIZE + 12) != STAR_EMPTY_SLOT) {
+            i = (i + 1) & (slot_count - 1);
+        }
+        uint8_t *slot = index + i * STAR_SLOT_SIZE;
+        write_u32(slot, h);
+        add_string(symbol.first, slot + 4);
+        write_u32(slot + 12, symbol.second);
+    }
+    return archive;
+}
@@ -0,0 +1,91 @@
+// File: archive.h
+// Owner: Team
+// Role: Static Libraries
+// Description: STAR static library archives: STAO objects stored back to back behind a
+//              prebuilt hash index from every global symbol to the member defining it,
+//              so the linker can find and parse only the members it needs.
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "mapped_file.h"
+#include "object_file.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// All fields are little-endian u32, and every section starts on a 4-byte boundary:
+//
+//   header   STAR_HEADER_SIZE bytes: magic, version, member count, members offset,
+//            slot count (a power of two), index offset, strings offset, strings size
+//   members  member count records of STAR_MEMBER_SIZE bytes:
+//            name offset, name length, object offset, object size
+//   index    slot count records of STAR_SLOT_SIZE bytes: name hash, name offset,
+//            name length, member index (STAR_EMPTY_SLOT if unused). Open addressing
+//            with linear probing from the 32-bit FNV-1a hash of the name.
+//   strings  member and symbol names, back to back, without terminators
+//   objects  each member's STAO bytes, unchanged, starting on a 4-byte boundary
+constexpr uint32_t STAR_MAGIC = 0x53544152; // "STAR"
+constexpr uint32_t STAR_VERSION = 1;
+constexpr uint32_t STAR_HEADER_SIZE = 32;
+constexpr uint32_t STAR_MEMBER_SIZE = 16;
+constexpr uint32_t STAR_SLOT_SIZE = 16;
+constexpr uint32_t STAR_EMPTY_SLOT = UINT32_MAX;
+
+// Byte offsets of the header fields.
+namespace star {
+constexpr uint32_t VERSION = 4;
+constexpr uint32_t MEMBER_COUNT = 8;
+constexpr uint32_t MEMBERS_OFFSET = 12;
+constexpr uint32_t SLOT_COUNT = 16;
+constexpr uint32_t INDEX_OFFSET = 20;
+constexpr uint32_t STRINGS_OFFSET = 24;
+constexpr uint32_t STRINGS_SIZE = 28;
+} // namespace star
+
+constexpr uint32_t NO_MEMBER = UINT32_MAX;
+
+// Read-side view of a mapped archive. Opening it only checks the header and
+// section bounds; members are parsed on request, in place.
+class Archive {
+public:
+    // True if `data` starts with the archive magic number.
+    static bool is_archive(const uint8_t *data, size_t size);
+
+    // Throws std::runtime_error if the file is not a well-formed archive.
+    static Archive from_mapping(std::shared_ptr<const MappedFile> file, const std::string &path);
+
+    const std::string &path() const { return file_path; }
+    uint32_t member_count() const { return members; }
+    std::string_view member_name(uint32_t member) const;
+
+    // The member defining global `symbol`, or NO_MEMBER.
+    uint32_t find(std::string_view symbol) const;
+
+    // Parses a member; errors name it as "<archive>(<member>)".
+    ParsedObjectFile load_member(uint32_t member) const;
+
+    // Every indexed symbol with its member, in index order.
+    std::vector<std::pair<std::string_view, uint32_t>> symbols() const;
+
+private:
+    std::string_view string_at(const uint8_t *record) const;
+
+    std::shared_ptr<const MappedFile> file;
+    std::string file_path;
+    const uint8_t *member_table = nullptr;
+    const uint8_t *index = nullptr;
+    const char *strings = nullptr;
+    uint32_t strings_size = 0;
+    uint32_t members = 0;
+    uint32_t slots = 0;
+};
+
+// Builds an archive holding `objects`, with `names` as their member names.
+// Throws std::runtime_error if two members define the same global symbol.
+std::vector<uint8_t> build_archive(const std::vector<ParsedObjectFile> &objects,
+                                   const std::vector<std::string> &names);
+
+#endif // ARCHIVE_H
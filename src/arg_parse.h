@@ -0,0 +1,27 @@
+// File: arg_parse.h
+// Owner: Team
+// Role: Command-Line Support
+// Description: Checked parsing of numeric command-line values, shared by the
+//              assembler, linker, VM, validator and benchmark tools.
+
+#ifndef ARG_PARSE_H
+#define ARG_PARSE_H
+
+#include <charconv>
+#include <string_view>
+#include <system_error>
+
+// Parses all of `text` as a T; returns false, leaving `value` unchanged, on
+// empty text, trailing characters or a value out of T's range. Unsigned types
+// reject a sign.
+template <typename T>
+bool parse_number(std::string_view text, T &value) {
+    const char *end = text.data() + text.size();
+    T parsed{};
+    auto [ptr, ec] = std::from_chars(text.data(), end, parsed);
+    if (text.empty() || ec != std::errc() || ptr != end) return false;
+    value = parsed;
+    return true;
+}
+
+#endif // ARG_PARSE_H
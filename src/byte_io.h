@@ -0,0 +1,93 @@
+// File: byte_io.h
+// Owner: Team
+// Role: Binary Format Support
+// Description: Little-endian helpers shared by the object-file, executable and
+//              link-map readers and writers.
+
+#ifndef BYTE_IO_H
+#define BYTE_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+inline void write_u32(uint8_t *p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>((value >> (i * 8)) & 0xFF);
+    }
+}
+
+inline uint32_t read_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Appends little-endian values to a growing byte buffer.
+class ByteWriter {
+public:
+    void u8(uint8_t v) { bytes.push_back(v); }
+    void u32(uint32_t v) {
+        for (int i = 0; i < 4; i++) bytes.push_back(static_cast<uint8_t>(v >> (i * 8)));
+    }
+    void u64(uint64_t v) {
+        u32(static_cast<uint32_t>(v));
+        u32(static_cast<uint32_t>(v >> 32));
+    }
+    void string(std::string_view s) {
+        u32(static_cast<uint32_t>(s.size()));
+        bytes.insert(bytes.end(), s.begin(), s.end());
+    }
+
+    std::vector<uint8_t> bytes;
+};
+
+// Bounds-checked little-endian reader over a byte range. `what` names the
+// input in error messages.
+class ByteReader {
+public:
+    ByteReader(const uint8_t *p, size_t n, const std::string &what) : pos(p), end(p + n), what(what) {}
+
+    uint8_t u8() {
+        need(1);
+        return *pos++;
+    }
+    uint32_t u32() {
+        need(4);
+        uint32_t v = read_u32(pos);
+        pos += 4;
+        return v;
+    }
+    uint64_t u64() {
+        uint64_t lo = u32();
+        return lo | (static_cast<uint64_t>(u32()) << 32);
+    }
+    std::string_view string() {
+        uint32_t length = u32();
+        need(length);
+        std::string_view s(reinterpret_cast<const char *>(pos), length);
+        pos += length;
+        return s;
+    }
+    const uint8_t *bytes(size_t n) {
+        need(n);
+        const uint8_t *p = pos;
+        pos += n;
+        return p;
+    }
+    size_t remaining() const { return static_cast<size_t>(end - pos); }
+
+private:
+    void need(size_t n) {
+        if (remaining() < n) {
+            throw std::runtime_error("Truncated file: " + what);
+        }
+    }
+
+    const uint8_t *pos;
+    const uint8_t *end;
+    std::string what;
+};
+
+#endif // BYTE_IO_H
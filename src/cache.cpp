@@ -0,0 +1,149 @@
+// File: cache.cpp
+// Owner: Team
+// Role: Assembly Cache
+// Description: Implementation of the content-addressed assembly cache.
+
+#include "cache.h"
+#include "driver.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// --- AssemblyCache ---
+AssemblyCache::AssemblyCache(const std::string &dir, uint64_t max) : directory(dir), max_bytes(max) {
+    fs::create_directories(directory);
+}
+
+uint64_t AssemblyCache::key_for_file(const std::string &source_path, const std::string &flags) {
+    std::ifstream file(source_path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open file: " + source_path);
+    }
+    ContentHash hash(ASSEMBLER_VERSION);
+    hash.update(flags.data(), flags.size());
+    hash.update("\0", 1);
+    char buffer[1 << 16];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+        hash.update(buffer, static_cast<size_t>(file.gcount()));
+    }
+    return hash.digest();
+}
+
+std::string AssemblyCache::entry_path(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%02x/%016llx.o", static_cast<unsigned>(key >> 56),
+                  static_cast<unsigned long long>(key));
+    return (fs::path(directory) / name).string();
+}
+
+bool AssemblyCache::fetch(uint64_t key, const std::string &output) {
+    std::string entry = entry_path(key);
+    std::error_code ec;
+    if (!fs::exists(entry, ec)) {
+        misses++;
+        return false;
+    }
+    fs::remove(output, ec);
+    fs::create_hard_link(entry, output, ec);
+    if (ec) {
+        ec.clear();
+        fs::copy_file(entry, output, fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            misses++;
+            return false;
+        }
+    }
+    // Entries are ranked for eviction by mtime, so a hit refreshes it.
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+    hits++;
+    return true;
+}
+
+void AssemblyCache::store(uint64_t key, const std::vector<uint8_t> &object) {
+    std::string entry = entry_path(key);
+    std::error_code ec;
+    fs::create_directories(fs::path(entry).parent_path(), ec);
+
+    // Write to a private temporary name, then rename into place atomically.
+    std::string temp = entry + ".tmp" + std::to_string(::getpid()) + "." +
+                       std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream out(temp, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(object.data()), object.size());
+        if (!out) {
+            fs::remove(temp, ec);
+            return;
+        }
+    }
+    // Cached objects are shared via hardlinks, so keep them read-only.
+    fs::permissions(temp, fs::perms::owner_read | fs::perms::group_read | fs::perms::others_read, ec);
+    fs::rename(temp, entry, ec);
+    if (ec) fs::remove(temp, ec);
+}
+
+struct CacheEntry {
+    fs::path path;
+    uint64_t size;
+    fs::file_time_type used;
+};
+
+static std::vector<CacheEntry> list_entries(const std::string &directory) {
+    std::vector<CacheEntry> entries;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(directory, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_regular_file(ec) && it->path().extension() == ".o") {
+            entries.push_back({it->path(), it->file_size(ec), it->last_write_time(ec)});
+        }
+    }
+    return entries;
+}
+
+static void read_counters(const std::string &path, uint64_t &hits, uint64_t &misses) {
+    std::ifstream in(path);
+    hits = misses = 0;
+    in >> hits >> misses;
+}
+
+void AssemblyCache::finish() {
+    std::vector<CacheEntry> entries = list_entries(directory);
+    uint64_t total = 0;
+    for (const auto &entry : entries) total += entry.size;
+    if (total > max_bytes) {
+        std::sort(entries.begin(), entries.end(),
+                  [](const CacheEntry &a, const CacheEntry &b) { return a.used < b.used; });
+        std::error_code ec;
+        for (const auto &entry : entries) {
+            if (total <= max_bytes) break;
+            if (fs::remove(entry.path, ec)) total -= entry.size;
+        }
+    }
+
+    std::string counters = (fs::path(directory) / "stats").string();
+    uint64_t total_hits, total_misses;
+    read_counters(counters, total_hits, total_misses);
+    std::ofstream out(counters, std::ios::trunc);
+    uint64_t run_hits = hits, run_misses = misses;
+    out << total_hits + run_hits - persisted_hits << " " << total_misses + run_misses - persisted_misses << "\n";
+    persisted_hits = run_hits;
+    persisted_misses = run_misses;
+}
+
+AssemblyCache::Stats AssemblyCache::stats() const {
+    Stats s;
+    for (const auto &entry : list_entries(directory)) {
+        s.entries++;
+        s.bytes += entry.size;
+    }
+    read_counters((fs::path(directory) / "stats").string(), s.hits, s.misses);
+    s.hits += hits - persisted_hits;
+    s.misses += misses - persisted_misses;
+    return s;
+}
@@ -0,0 +1,58 @@
+// File: cache.h
+// Owner: Team
+// Role: Assembly Cache
+// Description: A content-addressed on-disk cache of assembled object files. Entries are
+//              keyed by a hash of the source bytes, the assembler version and the flags
+//              that affect code generation, and evicted least-recently-used first.
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "content_hash.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class AssemblyCache {
+public:
+    struct Stats {
+        size_t entries = 0;
+        uint64_t bytes = 0;
+        uint64_t hits = 0;     // Lifetime counters, persisted in the cache directory.
+        uint64_t misses = 0;
+    };
+
+    AssemblyCache(const std::string &directory, uint64_t max_bytes);
+
+    // Computes the cache key for a source file. Throws std::runtime_error if it cannot be read.
+    static uint64_t key_for_file(const std::string &source_path, const std::string &flags);
+
+    // On a hit, hardlinks (or copies) the cached object to `output` and returns true.
+    bool fetch(uint64_t key, const std::string &output);
+
+    // Adds an object to the cache. Failures are ignored: the cache is only an accelerator.
+    void store(uint64_t key, const std::vector<uint8_t> &object);
+
+    // Evicts least-recently-used entries until the cache fits in max_bytes,
+    // and folds this run's hit/miss counts into the persistent totals.
+    void finish();
+
+    Stats stats() const;
+
+    uint64_t run_hits() const { return hits; }
+    uint64_t run_misses() const { return misses; }
+
+private:
+    std::string entry_path(uint64_t key) const;
+
+    std::string directory;
+    uint64_t max_bytes;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    uint64_t persisted_hits = 0;   // Portion of hits/misses already written by finish().
+    uint64_t persisted_misses = 0;
+};
+
+#endif // CACHE_H
@@ -0,0 +1,58 @@
+// File: content_hash.cpp
+// Owner: Team
+// Role: Hashing Support
+// Description: Implementation of ContentHash.
+
+#include "content_hash.h"
+#include <algorithm>
+#include <cstring>
+
+static constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+
+static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static uint64_t mix_word(uint64_t state, uint64_t word) {
+    state ^= rotl(word * PRIME_2, 31) * PRIME_1;
+    return rotl(state, 27) * PRIME_1 + 0x165667B19E3779F9ULL;
+}
+
+static uint64_t load_le64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+ContentHash::ContentHash(uint64_t seed) : state(seed ^ PRIME_1) {}
+
+void ContentHash::update(const void *data, size_t length) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    total += length;
+    if (tail_length > 0) {
+        size_t take = std::min(length, sizeof(tail) - tail_length);
+        std::memcpy(tail + tail_length, p, take);
+        tail_length += take;
+        p += take;
+        length -= take;
+        if (tail_length < sizeof(tail)) return;
+        state = mix_word(state, load_le64(tail));
+        tail_length = 0;
+    }
+    for (; length >= 8; p += 8, length -= 8) {
+        state = mix_word(state, load_le64(p));
+    }
+    std::memcpy(tail, p, length);
+    tail_length = length;
+}
+
+uint64_t ContentHash::digest() const {
+    uint64_t h = state;
+    uint8_t last[8] = {0};
+    std::memcpy(last, tail, tail_length);
+    h = mix_word(h, load_le64(last));
+    h ^= total;
+    h ^= h >> 33;
+    h *= PRIME_2;
+    h ^= h >> 29;
+    return h;
+}
@@ -0,0 +1,27 @@
+// File: content_hash.h
+// Owner: Team
+// Role: Hashing Support
+// Description: Fast incremental 64-bit content hash used to recognise unchanged
+//              inputs (assembly cache keys, incremental relinking).
+
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Incremental 64-bit hash over a byte stream (8 bytes per step).
+class ContentHash {
+public:
+    explicit ContentHash(uint64_t seed = 0);
+    void update(const void *data, size_t length);
+    uint64_t digest() const;
+
+private:
+    uint64_t state;
+    uint64_t total = 0;
+    uint8_t tail[8];
+    size_t tail_length = 0;
+};
+
+#endif // CONTENT_HASH_H
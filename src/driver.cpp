@@ -0,0 +1,192 @@
+// File: driver.cpp
+// Owner: Team
+// Role: Assembler Driver
+// Description: Implementation of the single- and multi-file assembly pipeline.
+
+#include "driver.h"
+#include "parser.h"
+#include "emitter.h"
+#include "thread_pool.h"
+#include "cache.h"
+#include "verifier.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+// Flags that change the emitted bytes; part of the cache key.
+static std::string codegen_flags(const AssemblerOptions &options) {
+    std::string flags = options.optimize ? "-O" : "";
+    if (options.verify) {
+        flags += "+verify"; // A failed verification is never cached, but keep the keys apart anyway.
+    }
+    return flags;
+}
+
+// Checks the operand-stack use of every function in the unit. The roots are the
+// global TEXT symbols (entry points other objects can reach), or the first
+// instruction when there are none; jmp/invoke targets defined elsewhere are not
+// followed. Throws std::runtime_error if verification fails.
+static void verify_unit(const AssemblyUnit &unit, AssemblyResult &result) {
+    const SymbolTable &symbols = unit.symbol_table;
+    auto target = [&](int32_t operand) {
+        const Symbol &symbol = symbols[static_cast<SymbolId>(operand)];
+        return symbol.type == Symbol::Type::TEXT ? static_cast<int32_t>(symbol.address) : EXTERNAL_TARGET;
+    };
+    const InstructionStream &instructions = unit.instructions;
+    std::vector<DecodedInstruction> code(instructions.size());
+    for (size_t i = 0; i < instructions.size(); i++) {
+        Opcode op = instructions.opcodes[i];
+        bool branch = op == Opcode::JMP || op == Opcode::INVOKE;
+        int32_t operand = instructions.operands[i];
+        code[i] = {op, instructions.arg_counts[i], branch ? target(operand) : operand};
+    }
+
+    std::vector<uint32_t> roots;
+    for (SymbolId id = 0; id < symbols.size(); id++) {
+        const Symbol &symbol = symbols[id];
+        if (symbol.type == Symbol::Type::TEXT && symbol.binding == Symbol::Binding::GLOBAL) {
+            roots.push_back(symbol.address);
+        }
+    }
+    if (roots.empty() && !code.empty()) {
+        roots.push_back(0);
+    }
+
+    StackVerification verification = verify_stack(code, roots);
+    if (!verification.ok) {
+        throw std::runtime_error("Stack verification failed: " + verification.error);
+    }
+    result.verified_functions = verification.functions.size();
+    for (const FunctionDepth &fn : verification.functions) {
+        result.max_stack_depth = std::max(result.max_stack_depth, fn.max_depth);
+    }
+}
+
+// Runs the optional optimizer and the emitter over a parsed unit; the emitter
+// uses `pool` when given.
+static std::vector<uint8_t> compile_unit(AssemblyUnit &unit, const AssemblerOptions &options,
+                                         AssemblyResult &result, AssemblyStats *stats,
+                                         ThreadPool *pool = nullptr) {
+    result.instructions = unit.instructions.size();
+    result.symbols = unit.symbol_table.size();
+    result.data_entries = unit.data.entries;
+    result.included_files = unit.data.includes.size();
+    if (options.optimize) {
+        PhaseTimer timer(stats, Phase::OPTIMIZE);
+        result.optimizer = optimize(unit);
+        result.optimized = true;
+    }
+    if (options.verify) {
+        PhaseTimer timer(stats, Phase::VERIFY);
+        verify_unit(unit, result);
+    }
+    std::vector<uint8_t> bytecode = emit_object_file(unit, stats, pool);
+    result.bytes = bytecode.size();
+    return bytecode;
+}
+
+AssemblyResult assemble_file(const std::string &input, const std::string &output,
+                             const AssemblerOptions &options) {
+    AssemblyResult result;
+    result.input = input;
+    result.output = output;
+    AssemblyStats *stats = options.collect_stats ? &result.stats : nullptr;
+    try {
+        AssemblyCache *cache = input == "-" ? nullptr : options.cache;
+        uint64_t key = 0;
+        if (cache) {
+            key = AssemblyCache::key_for_file(input, codegen_flags(options));
+            // A hit's only work is producing the output, so the lookup counts as the write.
+            PhaseTimer fetch_timer(stats, Phase::WRITE);
+            if (cache->fetch(key, output)) {
+                result.bytes = fs::file_size(output);
+                result.cached = true;
+                result.ok = true;
+                return result;
+            }
+        }
+
+        // A large file is mapped and split across its own pool; the object is the same.
+        AssemblyUnit unit;
+        std::unique_ptr<ThreadPool> pool;
+        std::error_code size_error;
+        uint64_t source_size = input == "-" ? 0 : fs::file_size(input, size_error);
+        if (options.file_jobs != 1 && !size_error && source_size >= PARALLEL_PARSE_MIN_BYTES) {
+            pool = std::make_unique<ThreadPool>(options.file_jobs);
+            MappedFile source = MappedFile::open_read(input);
+            unit = parse_buffer_parallel(std::string_view(reinterpret_cast<const char *>(source.data()), source.size()),
+                                         *pool, stats, PARALLEL_CHUNK_BYTES, input);
+        } else {
+            unit = parse_file(input, stats);
+        }
+        if (stats && input != "-") {
+            stats->source_bytes = source_size;
+        }
+        std::vector<uint8_t> bytecode = compile_unit(unit, options, result, stats, pool.get());
+
+        // The key covers only the source text, not the files it includes.
+        if (cache && result.included_files == 0) {
+            cache->store(key, bytecode);
+        }
+
+        // Replace rather than overwrite: the old output may be a hardlink into the cache.
+        PhaseTimer write_timer(stats, Phase::WRITE);
+        std::error_code ec;
+        if (fs::is_regular_file(output, ec)) {
+            fs::remove(output, ec);
+        }
+        std::ofstream outfile(output, std::ios::binary);
+        if (!outfile) {
+            throw std::runtime_error("Cannot open output file for writing.");
+        }
+        outfile.write(reinterpret_cast<const char*>(bytecode.data()), bytecode.size());
+        if (!outfile) {
+            throw std::runtime_error("Failed writing output file.");
+        }
+        result.ok = true;
+    } catch (const std::exception &e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+std::vector<uint8_t> assemble_source(std::string_view source, const AssemblerOptions &options,
+                                     AssemblyResult &result, const std::string &source_path) {
+    AssemblyStats *stats = options.collect_stats ? &result.stats : nullptr;
+    AssemblyUnit unit = parse_buffer(source, stats, source_path);
+    if (stats) {
+        stats->source_bytes = source.size();
+    }
+    return compile_unit(unit, options, result, stats);
+}
+
+std::vector<AssemblyResult> assemble_files(const std::vector<std::string> &inputs,
+                                           const std::string &output_dir, unsigned jobs,
+                                           const AssemblerOptions &options) {
+    std::vector<AssemblyResult> results(inputs.size());
+
+    // Output names are decided up front so collisions are caught deterministically.
+    std::vector<std::string> outputs(inputs.size());
+    std::unordered_set<std::string> seen;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        outputs[i] = (fs::path(output_dir) / fs::path(inputs[i]).stem()).string() + ".o";
+        if (!seen.insert(outputs[i]).second) {
+            throw std::runtime_error("Two inputs map to the same output file: " + outputs[i]);
+        }
+    }
+
+    // The files already share the pool; a nested one per file would oversubscribe it.
+    AssemblerOptions per_file = options;
+    per_file.file_jobs = 1;
+    ThreadPool pool(jobs);
+    pool.parallel_for(inputs.size(), [&](size_t i) {
+        results[i] = assemble_file(inputs[i], outputs[i], per_file);
+    });
+    return results;
+}
@@ -0,0 +1,75 @@
+// File: driver.h
+// Owner: Team
+// Role: Assembler Driver
+// Description: Runs the parse -> emit -> write pipeline for one or many source files.
+
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include "optimizer.h"
+#include "stats.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class AssemblyCache;
+
+// Bump whenever the emitted object bytes can change for the same source;
+// it is part of every cache key.
+constexpr uint64_t ASSEMBLER_VERSION = 10;
+
+// Settings shared by every file in one assembler run.
+struct AssemblerOptions
+{
+    AssemblyCache *cache = nullptr; // Optional; stdin input and sources using .incbin are never cached.
+    bool optimize = false;          // Run the peephole optimizer (-O) before emission.
+    bool verify = false;            // Reject code whose stack depth cannot be proven (--verify).
+    bool collect_stats = false;     // Fill AssemblyResult::stats (--stats).
+    unsigned file_jobs = 1;         // Threads for one input of at least PARALLEL_PARSE_MIN_BYTES
+                                    // (0 = one per hardware thread); 1 keeps it sequential.
+};
+
+// Outcome of assembling a single source file.
+struct AssemblyResult
+{
+    std::string input;
+    std::string output;
+    bool ok = false;
+    std::string error;        // Set when ok is false.
+    size_t instructions = 0;
+    size_t symbols = 0;
+    size_t data_entries = 0;
+    size_t included_files = 0; // .incbin inputs; the object is not cached when there are any.
+    size_t bytes = 0;         // Size of the emitted object file.
+    bool cached = false;      // True when the object was reused from the cache.
+    bool optimized = false;   // True when `optimizer` describes an -O pass.
+    OptimizerStats optimizer;
+    size_t verified_functions = 0; // Functions proven by --verify.
+    uint32_t max_stack_depth = 0;  // Deepest frame among them, in values.
+    AssemblyStats stats;      // Per-phase costs; only filled with collect_stats.
+};
+
+// Assembles `input` ("-" for stdin) into the object file `output`.
+// Never throws; failures are reported through AssemblyResult::error.
+AssemblyResult assemble_file(const std::string &input, const std::string &output,
+                             const AssemblerOptions &options = {});
+
+// Assembles source held in memory and returns the object file bytes; the
+// counters in `result` are filled as for assemble_file. Throws
+// std::runtime_error on assembly errors. Never touches the cache.
+// `source_path`, when given, names the file the source was read from, for
+// resolving relative .incbin paths.
+std::vector<uint8_t> assemble_source(std::string_view source, const AssemblerOptions &options,
+                                     AssemblyResult &result, const std::string &source_path = {});
+
+// Assembles every input into `output_dir`/<stem>.o using `jobs` worker threads
+// (0 = one per hardware thread). Results are returned in input order, so the
+// report does not depend on scheduling. Each file is assembled on one thread,
+// whatever options.file_jobs says.
+std::vector<AssemblyResult> assemble_files(const std::vector<std::string> &inputs,
+                                           const std::string &output_dir, unsigned jobs,
+                                           const AssemblerOptions &options = {});
+
+#endif // DRIVER_H
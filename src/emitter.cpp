@@ -1,160 +1,345 @@
 // File: emitter.cpp
 // Owner: CS22B015 Kowshik
 // Role: Bytecode & Back-end
-// Description: Implementation of the object file emitter.
+// Description: Implementation of the object file emitter, including the layout pass that
+//              picks short encodings and assigns byte offsets to code labels.
 
 #include "emitter.h"
 #include "structures.h"
-#include <stdexcept>
+#include "object_file.h"
+#include "thread_pool.h"
 #include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
 
 // --- Helper functions ---
-void write_int32(std::vector<uint8_t> &vec, int32_t value) {
+// Each writer stores little-endian bytes at `out` and returns the next free position.
+uint8_t *write_int32(uint8_t *out, int32_t value) {
     for (int i = 0; i < 4; i++) {
-        vec.push_back(static_cast<uint8_t>((value >> (i * 8)) & 0xFF));
+        out[i] = static_cast<uint8_t>((value >> (i * 8)) & 0xFF);
     }
+    return out + 4;
 }
 
-void write_string(std::vector<uint8_t> &vec, const std::string &str) {
-    write_int32(vec, static_cast<int32_t>(str.length()));
-    vec.insert(vec.end(), str.begin(), str.end());
+uint8_t *write_int16(uint8_t *out, int32_t value) {
+    out[0] = static_cast<uint8_t>(value & 0xFF);
+    out[1] = static_cast<uint8_t>((value >> 8) & 0xFF);
+    return out + 2;
 }
 
-// --- Opcodes ---
-enum class Opcode : uint8_t {
-    ICONST = 0x01,
-    IADD   = 0x02,
-    ISUB   = 0x03,
-    IMUL   = 0x04,
-    IDIV   = 0x05,
-    RET    = 0x06,
-    JMP    = 0x07,
-    INVOKE = 0x08
-};
-
 // --- Symbol lookup ---
-const Symbol* find_symbol(const AssemblyUnit &unit, const std::string &name) {
-    for (const auto &sym : unit.symbol_table) {
-        if (sym.name == name) return &sym;
+const Symbol& branch_target(const AssemblyUnit &unit, SymbolId target) {
+    if (target == NO_SYMBOL || target >= unit.symbol_table.size()) {
+        throw std::runtime_error("Unresolved branch target");
     }
-    return nullptr;
+    return unit.symbol_table[target];
 }
 
-// --- Instruction implementations ---
-std::vector<uint8_t> IConst::emit(const AssemblyUnit &, RelocationEntry &) const {
-    std::vector<uint8_t> code;
-    code.push_back(static_cast<uint8_t>(Opcode::ICONST));
-    write_int32(code, value);
-    return code;
+// Global targets must be patched by the linker; local ones are encoded directly.
+bool needs_relocation(const AssemblyUnit &unit, Opcode op, int32_t operand) {
+    return is_branch(op) &&
+           branch_target(unit, static_cast<SymbolId>(operand)).binding == Symbol::Binding::GLOBAL;
 }
 
-std::vector<uint8_t> IAdd::emit(const AssemblyUnit &, RelocationEntry &) const {
-    return { static_cast<uint8_t>(Opcode::IADD) };
-}
+// --- Ranges ---
+// With a thread pool, the per-instruction passes run over consecutive ranges
+// of at least this many instructions, one task per range.
+constexpr size_t RANGE_INSTRUCTIONS = 1 << 16;
 
-std::vector<uint8_t> ISub::emit(const AssemblyUnit &, RelocationEntry &) const {
-    return { static_cast<uint8_t>(Opcode::ISUB) };
+// Start of every range and, last, `count`. A single range without a pool.
+std::vector<size_t> split_ranges(size_t count, ThreadPool *pool) {
+    size_t ranges = pool ? std::max<size_t>(1, count / RANGE_INSTRUCTIONS) : 1;
+    std::vector<size_t> starts(ranges + 1);
+    for (size_t r = 0; r <= ranges; r++) {
+        starts[r] = count * r / ranges;
+    }
+    return starts;
 }
 
-std::vector<uint8_t> IMul::emit(const AssemblyUnit &, RelocationEntry &) const {
-    return { static_cast<uint8_t>(Opcode::IMUL) };
+// Pool tasks charge their CPU time and allocations to `phase`.
+void for_each_range(ThreadPool *pool, size_t ranges, AssemblyStats *stats, Phase phase,
+                    const std::function<void(size_t)> &body) {
+    if (pool && ranges > 1) {
+        pool->parallel_for(ranges, [&](size_t r) {
+            TaskTimer task_timer(stats, phase);
+            body(r);
+        });
+    } else {
+        for (size_t r = 0; r < ranges; r++) body(r);
+    }
 }
 
-std::vector<uint8_t> IDiv::emit(const AssemblyUnit &, RelocationEntry &) const {
-    return { static_cast<uint8_t>(Opcode::IDIV) };
-}
+// --- Layout ---
+// The encoding chosen for every instruction. offsets[i] is the byte offset of
+// instruction i and offsets[size()] the code size, so offsets also maps label
+// addresses (instruction indices) to byte offsets. Range r holds instructions
+// range_starts[r] .. range_starts[r + 1] - 1 and relocation entries
+// reloc_starts[r] .. reloc_starts[r + 1] - 1.
+struct CodeLayout
+{
+    std::vector<Opcode> forms;
+    std::vector<uint32_t> offsets;
+    std::vector<size_t> range_starts;
+    std::vector<uint32_t> reloc_starts;
+    uint32_t reloc_count = 0;
+};
 
-std::vector<uint8_t> Ret::emit(const AssemblyUnit &, RelocationEntry &) const {
-    return { static_cast<uint8_t>(Opcode::RET) };
+Opcode constant_form(int32_t value) {
+    if (value >= INT8_MIN && value <= INT8_MAX) return Opcode::ICONST8;
+    if (value >= INT16_MIN && value <= INT16_MAX) return Opcode::ICONST16;
+    return Opcode::ICONST;
 }
 
-std::vector<uint8_t> Jmp::emit(const AssemblyUnit &unit, RelocationEntry &reloc) const {
-    std::vector<uint8_t> code;
-    code.push_back(static_cast<uint8_t>(Opcode::JMP));
-    const Symbol *target = find_symbol(unit, label);
-    if (!target) {
-        throw std::runtime_error("Undefined symbol: " + label);
-    }
-    if (target->binding == Symbol::Binding::LOCAL) {
-        write_int32(code, target->address);
-    } else {
-        write_int32(code, 0); // placeholder
-        reloc.target_symbol = label;
+// Whether a branch in `form` can reach a target `displacement` bytes past its end.
+bool reaches(Opcode form, int64_t displacement) {
+    switch (form) {
+        case Opcode::JMP8:
+        case Opcode::INVOKE8:  return displacement >= INT8_MIN && displacement <= INT8_MAX;
+        case Opcode::JMP16:
+        case Opcode::INVOKE16: return displacement >= INT16_MIN && displacement <= INT16_MAX;
+        default:               return true; // Long forms hold an absolute address.
     }
-    return code;
 }
 
-std::vector<uint8_t> Invoke::emit(const AssemblyUnit &unit, RelocationEntry &reloc) const {
-    std::vector<uint8_t> code;
-    code.push_back(static_cast<uint8_t>(Opcode::INVOKE));
-    const Symbol *target = find_symbol(unit, label);
-    if (!target) {
-        throw std::runtime_error("Undefined symbol: " + label);
+Opcode next_larger(Opcode form) {
+    switch (form) {
+        case Opcode::JMP8:    return Opcode::JMP16;
+        case Opcode::JMP16:   return Opcode::JMP;
+        case Opcode::INVOKE8: return Opcode::INVOKE16;
+        default:              return Opcode::INVOKE;
     }
-    if (target->binding == Symbol::Binding::LOCAL) {
-        write_int32(code, target->address);
-    } else {
-        write_int32(code, 0); // placeholder
-        reloc.target_symbol = label;
-    }
-    code.push_back(num_args);
-    return code;
 }
 
-// --- Main Emitter Function ---
-std::vector<uint8_t> emit_object_file(const AssemblyUnit &unit) {
-    std::vector<uint8_t> code_section;
-    std::vector<RelocationEntry> relocation_table;
-
-    // 1. Generate Code Section
-    for (const auto &instr : unit.instructions) {
-        RelocationEntry reloc_entry;
-        uint32_t offset = code_section.size();
-        std::vector<uint8_t> instr_bytes = instr->emit(unit, reloc_entry);
-        code_section.insert(code_section.end(), instr_bytes.begin(), instr_bytes.end());
-        if (!reloc_entry.target_symbol.empty()) {
-            reloc_entry.offset = offset + 1; // address after opcode
-            relocation_table.push_back(reloc_entry);
+// Branch relaxation: every local branch starts in its 8-bit form, and any
+// that cannot reach its target grows one step, until nothing grows. Forms
+// only ever grow, so this reaches a fixed point. Relocated branches keep the
+// long form, since their target is only known to the linker. Each round sizes
+// the ranges, takes their base offsets as a prefix sum, then fills in offsets
+// and checks branches range by range; the result does not depend on the
+// number of ranges.
+CodeLayout lay_out(const AssemblyUnit &unit, AssemblyStats *stats, ThreadPool *pool) {
+    const InstructionStream &instrs = unit.instructions;
+    const size_t n = instrs.size();
+    CodeLayout layout;
+    layout.forms.resize(n);
+    layout.offsets.resize(n + 1);
+    layout.range_starts = split_ranges(n, pool);
+    const std::vector<size_t> &starts = layout.range_starts;
+    const size_t ranges = starts.size() - 1;
+
+    std::vector<std::vector<uint32_t>> local_branches(ranges);
+    std::vector<std::string> errors(ranges);
+    layout.reloc_starts.assign(ranges + 1, 0);
+    for_each_range(pool, ranges, stats, Phase::LAYOUT, [&](size_t r) {
+        try {
+            for (size_t i = starts[r]; i < starts[r + 1]; i++) {
+                Opcode op = instrs.opcodes[i];
+                layout.forms[i] = op;
+                if (op == Opcode::ICONST) {
+                    layout.forms[i] = constant_form(instrs.operands[i]);
+                } else if (is_branch(op)) {
+                    const Symbol &sym = branch_target(unit, static_cast<SymbolId>(instrs.operands[i]));
+                    if (sym.binding == Symbol::Binding::GLOBAL) {
+                        layout.reloc_starts[r + 1]++;
+                    } else if (sym.type != Symbol::Type::TEXT || sym.address > n) {
+                        throw std::runtime_error("Branch target '" + std::string(unit.symbol_table.name(
+                                                     static_cast<SymbolId>(instrs.operands[i]))) + "' is not a code label");
+                    } else {
+                        layout.forms[i] = op == Opcode::JMP ? Opcode::JMP8 : Opcode::INVOKE8;
+                        local_branches[r].push_back(static_cast<uint32_t>(i));
+                    }
+                }
+            }
+        } catch (const std::runtime_error &e) {
+            errors[r] = e.what();
         }
+    });
+    for (const std::string &error : errors) {
+        if (!error.empty()) throw std::runtime_error(error);
     }
+    for (size_t r = 0; r < ranges; r++) {
+        layout.reloc_starts[r + 1] += layout.reloc_starts[r];
+    }
+    layout.reloc_count = layout.reloc_starts[ranges];
+
+    std::vector<uint32_t> bases(ranges, 0);
+    std::vector<char> grew_in(ranges);
+    for (bool grew = true; grew;) {
+        // The last range's size is not needed for any base.
+        for_each_range(pool, ranges - 1, stats, Phase::LAYOUT, [&](size_t r) {
+            uint32_t size = 0;
+            for (size_t i = starts[r]; i < starts[r + 1]; i++) {
+                size += encoded_size(layout.forms[i]);
+            }
+            bases[r + 1] = size;
+        });
+        for (size_t r = 1; r < ranges; r++) {
+            bases[r] += bases[r - 1];
+        }
+        for_each_range(pool, ranges, stats, Phase::LAYOUT, [&](size_t r) {
+            uint32_t offset = bases[r];
+            for (size_t i = starts[r]; i < starts[r + 1]; i++) {
+                layout.offsets[i] = offset;
+                offset += encoded_size(layout.forms[i]);
+            }
+            if (r + 1 == ranges) layout.offsets[n] = offset;
+        });
 
-    // 2. Generate Data Section
-    std::vector<uint8_t> data_section;
-    for (const auto &data : unit.data_entries) {
-        write_int32(data_section, data.value);
+        for_each_range(pool, ranges, stats, Phase::LAYOUT, [&](size_t r) {
+            grew_in[r] = false;
+            for (uint32_t i : local_branches[r]) {
+                uint32_t target = branch_target(unit, static_cast<SymbolId>(instrs.operands[i])).address;
+                int64_t displacement = static_cast<int64_t>(layout.offsets[target]) - layout.offsets[i + 1];
+                if (!reaches(layout.forms[i], displacement)) {
+                    layout.forms[i] = next_larger(layout.forms[i]);
+                    grew_in[r] = true;
+                }
+            }
+        });
+        grew = std::find(grew_in.begin(), grew_in.end(), true) != grew_in.end();
     }
+    return layout;
+}
 
-    // 3. Generate Symbol Table Section
-    std::vector<uint8_t> symbol_table_section;
-    write_int32(symbol_table_section, unit.symbol_table.size());
-    for (const auto &sym : unit.symbol_table) {
-        write_string(symbol_table_section, sym.name);
-        symbol_table_section.push_back(static_cast<uint8_t>(sym.type));
-        symbol_table_section.push_back(static_cast<uint8_t>(sym.binding));
-        write_int32(symbol_table_section, sym.address);
+// --- Main Emitter Function ---
+// Writes STAO v2; see object_file.h for the layout.
+std::vector<uint8_t> emit_object_file(const AssemblyUnit &unit, AssemblyStats *stats, ThreadPool *pool) {
+    PhaseTimer layout_timer(stats, Phase::LAYOUT);
+
+    // 1. Choose every encoding, then size every section up front so the whole
+    // file is a single allocation.
+    const InstructionStream &instrs = unit.instructions;
+    CodeLayout layout = lay_out(unit, stats, pool);
+    uint32_t code_size = layout.offsets.back();
+    uint32_t reloc_count = layout.reloc_count;
+    uint32_t data_size = unit.data.size; // .space adds only a size to the header.
+    uint32_t symbol_count = static_cast<uint32_t>(unit.symbol_table.size());
+    // Symbol names are unique and already interned back to back, so the pool is the string table.
+    const std::string &strings = unit.symbol_table.string_pool();
+
+    // Laid out in 64 bits: every offset and size in the file must fit in a u32.
+    uint64_t code_offset = STAO2_HEADER_SIZE;
+    uint64_t data_offset = code_offset + ((uint64_t(code_size) + 3) & ~uint64_t(3));
+    uint64_t symbols_offset = data_offset + ((uint64_t(data_size) + 3) & ~uint64_t(3));
+    uint64_t relocs_offset = symbols_offset + uint64_t(symbol_count) * STAO2_SYMBOL_SIZE;
+    uint64_t strings_offset = relocs_offset + uint64_t(reloc_count) * STAO2_RELOC_SIZE;
+    uint64_t file_size = strings_offset + strings.size();
+    if (file_size > UINT32_MAX) {
+        throw std::runtime_error("Object file exceeds 4 GiB.");
     }
 
-    // 4. Generate Relocation Table Section
-    std::vector<uint8_t> reloc_table_section;
-    write_int32(reloc_table_section, relocation_table.size());
-    for (const auto &reloc : relocation_table) {
-        write_int32(reloc_table_section, reloc.offset);
-        write_string(reloc_table_section, reloc.target_symbol);
+    std::vector<uint8_t> object_file(file_size);
+    uint8_t *header = object_file.data();
+    uint8_t *code = header + code_offset;
+    uint8_t *data = header + data_offset;
+    uint8_t *symbols = header + symbols_offset;
+    uint8_t *relocs = header + relocs_offset;
+
+    layout_timer.stop();
+
+    // 2. Header
+    PhaseTimer code_timer(stats, Phase::CODE);
+    write_int32(header, STAO2_MAGIC);
+    write_int32(header + stao2::VERSION, STAO2_VERSION);
+    write_int32(header + stao2::CODE_OFFSET, static_cast<uint32_t>(code_offset));
+    write_int32(header + stao2::CODE_SIZE, code_size);
+    write_int32(header + stao2::DATA_OFFSET, static_cast<uint32_t>(data_offset));
+    write_int32(header + stao2::DATA_SIZE, data_size);
+    write_int32(header + stao2::SYMBOLS_OFFSET, static_cast<uint32_t>(symbols_offset));
+    write_int32(header + stao2::SYMBOL_COUNT, symbol_count);
+    write_int32(header + stao2::RELOCS_OFFSET, static_cast<uint32_t>(relocs_offset));
+    write_int32(header + stao2::RELOC_COUNT, reloc_count);
+    write_int32(header + stao2::STRINGS_OFFSET, static_cast<uint32_t>(strings_offset));
+    write_int32(header + stao2::STRINGS_SIZE, static_cast<uint32_t>(strings.size()));
+    write_int32(header + stao2::ZERO_SIZE, unit.data.zero_size);
+
+    // 3. Code Section, with relocation entries written as they are discovered;
+    // each range starts at its own first relocation entry.
+    for_each_range(pool, layout.range_starts.size() - 1, stats, Phase::CODE, [&](size_t r) {
+        uint8_t *range_relocs = relocs + layout.reloc_starts[r] * STAO2_RELOC_SIZE;
+        for (size_t i = layout.range_starts[r]; i < layout.range_starts[r + 1]; i++) {
+            Opcode form = layout.forms[i];
+            int32_t operand = instrs.operands[i];
+            uint8_t *out = code + layout.offsets[i];
+            *out = static_cast<uint8_t>(form);
+            if (is_relative_branch(form)) {
+                uint32_t target = layout.offsets[branch_target(unit, static_cast<SymbolId>(operand)).address];
+                operand = static_cast<int32_t>(target - layout.offsets[i + 1]);
+            }
+            switch (form) {
+                case Opcode::ICONST:
+                case Opcode::ICONST_IADD:
+                case Opcode::ICONST_ISUB:
+                case Opcode::ICONST_IMUL:
+                case Opcode::ICONST_IDIV:
+                    write_int32(out + 1, operand);
+                    break;
+                case Opcode::ICONST8:
+                case Opcode::JMP8:
+                case Opcode::INVOKE8:
+                    out[1] = static_cast<uint8_t>(operand);
+                    break;
+                case Opcode::ICONST16:
+                case Opcode::JMP16:
+                case Opcode::INVOKE16:
+                    write_int16(out + 1, operand);
+                    break;
+                case Opcode::JMP:
+                case Opcode::INVOKE: {
+                    const Symbol &sym = branch_target(unit, static_cast<SymbolId>(operand));
+                    if (sym.binding == Symbol::Binding::LOCAL) {
+                        write_int32(out + 1, layout.offsets[sym.address]);
+                    } else {
+                        write_int32(out + 1, 0); // placeholder
+                        range_relocs = write_int32(range_relocs, static_cast<uint32_t>(out + 1 - code)); // address after opcode
+                        range_relocs = write_int32(range_relocs, static_cast<uint32_t>(operand));        // target symbol index
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            if (long_form(form) == Opcode::INVOKE) {
+                out[encoded_size(form) - 1] = instrs.arg_counts[i];
+            }
+        }
+    });
+
+    code_timer.stop();
+
+    // 4. Data Section
+    PhaseTimer stitch_timer(stats, Phase::STITCH);
+    // Values are already little-endian bytes; included files are copied straight
+    // from their mappings.
+    const std::vector<uint8_t> &bytes = unit.data.bytes;
+    size_t copied = 0;
+    for (const DataInclude &include : unit.data.includes) {
+        data = std::copy(bytes.begin() + copied, bytes.begin() + include.at, data);
+        if (include.file->size() > 0) {
+            std::memcpy(data, include.file->data(), include.file->size());
+        }
+        data += include.file->size();
+        copied = include.at;
     }
+    std::copy(bytes.begin() + copied, bytes.end(), data);
 
-    // 5. Stitch everything together
-    std::vector<uint8_t> object_file;
-    uint32_t magic_number = 0x5354414F; // "STAO"
-    write_int32(object_file, magic_number);
-    write_int32(object_file, code_section.size());
-    write_int32(object_file, data_section.size());
-    write_int32(object_file, symbol_table_section.size());
-    write_int32(object_file, reloc_table_section.size());
-
-    object_file.insert(object_file.end(), code_section.begin(), code_section.end());
-    object_file.insert(object_file.end(), data_section.begin(), data_section.end());
-    object_file.insert(object_file.end(), symbol_table_section.begin(), symbol_table_section.end());
-    object_file.insert(object_file.end(), reloc_table_section.begin(), reloc_table_section.end());
+    // 5. Symbol Table and String Table Sections
+    std::vector<size_t> symbol_starts = split_ranges(symbol_count, pool);
+    for_each_range(pool, symbol_starts.size() - 1, stats, Phase::STITCH, [&](size_t r) {
+        for (size_t id = symbol_starts[r]; id < symbol_starts[r + 1]; id++) {
+            const Symbol &sym = unit.symbol_table[static_cast<SymbolId>(id)];
+            uint8_t *record = symbols + id * STAO2_SYMBOL_SIZE;
+            write_int32(record, sym.name_offset);
+            write_int32(record + 4, sym.name_length);
+            // Code labels were instruction indices until now; the object stores byte offsets.
+            write_int32(record + 8, sym.type == Symbol::Type::TEXT ? layout.offsets[sym.address] : sym.address);
+            record[12] = static_cast<uint8_t>(sym.type);
+            record[13] = static_cast<uint8_t>(sym.binding);
+        }
+    });
+    std::memcpy(header + strings_offset, strings.data(), strings.size());
 
     return object_file;
 }
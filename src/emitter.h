@@ -7,10 +7,17 @@
 #define EMITTER_H
 
 #include "structures.h"
+#include "stats.h"
 #include <vector>
 #include <cstdint>
 
+class ThreadPool;
+
 // Takes a complete AssemblyUnit and returns the binary for a relocatable object file (.o).
-std::vector<uint8_t> emit_object_file(const AssemblyUnit &unit);
+// Phase times go to `stats` when given. With a `pool`, large units are laid out
+// and encoded in parallel ranges; the bytes are the same either way. Must not be
+// called from a task running on `pool`.
+std::vector<uint8_t> emit_object_file(const AssemblyUnit &unit, AssemblyStats *stats = nullptr,
+                                      ThreadPool *pool = nullptr);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,226 @@
+// File: jit.cpp
+// Owner: Team
+// Role: Virtual Machine
+// Description: Implementation of the baseline JIT: trace selection, x86-64 code
+//              generation with the top of stack cached in eax, and the code arena.
+
+#include "jit.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// Emits the handful of x86-64 instructions the JIT needs. Stack slots are
+// addressed as [rdi + disp32], rdi holding the stack pointer at entry.
+class Assembler {
+public:
+    std::vector<uint8_t> code;
+
+    void u8(uint8_t b) { code.push_back(b); }
+    void u32(uint32_t v) {
+        for (int i = 0; i < 4; i++) {
+            code.push_back(static_cast<uint8_t>(v >> (i * 8)));
+        }
+    }
+    void slot(int32_t depth) { u32(static_cast<uint32_t>(depth * 4)); }
+
+    void store_eax(int32_t depth) { u8(0x89); u8(0x87); slot(depth); }       // mov [rdi+d], eax
+    void load_eax(int32_t depth) { u8(0x8B); u8(0x87); slot(depth); }        // mov eax, [rdi+d]
+    void load_ecx(int32_t depth) { u8(0x8B); u8(0x8F); slot(depth); }        // mov ecx, [rdi+d]
+    void mov_eax_imm(int32_t v) { u8(0xB8); u32(v); }                        // mov eax, imm32
+    void mov_ecx_imm(int32_t v) { u8(0xB9); u32(v); }                        // mov ecx, imm32
+    void add_eax_slot(int32_t depth) { u8(0x03); u8(0x87); slot(depth); }    // add eax, [rdi+d]
+    void imul_eax_slot(int32_t depth) { u8(0x0F); u8(0xAF); u8(0x87); slot(depth); } // imul eax, [rdi+d]
+    void add_eax_imm(int32_t v) { u8(0x05); u32(v); }                        // add eax, imm32
+    void sub_eax_imm(int32_t v) { u8(0x2D); u32(v); }                        // sub eax, imm32
+    void imul_eax_imm(int32_t v) { u8(0x69); u8(0xC0); u32(v); }             // imul eax, eax, imm32
+    void sub_eax_ecx() { u8(0x29); u8(0xC8); }                               // sub eax, ecx
+    void xchg_eax_ecx() { u8(0x91); }                                        // xchg eax, ecx
+    void neg_eax() { u8(0xF7); u8(0xD8); }                                   // neg eax
+    void xor_eax_eax() { u8(0x31); u8(0xC0); }                               // xor eax, eax
+    void ret() { u8(0xC3); }
+
+    // eax = eax / ecx with the VM's semantics (INT_MIN / -1 == INT_MIN);
+    // the caller has already ruled out ecx == 0.
+    void idiv_eax_ecx() {
+        u8(0x83); u8(0xF9); u8(0xFF);  // cmp ecx, -1
+        u8(0x75); u8(0x04);            // jne +4
+        neg_eax();                     // a / -1 == -a, and -INT_MIN wraps to INT_MIN
+        u8(0xEB); u8(0x03);            // jmp +3
+        u8(0x99);                      // cdq
+        u8(0xF7); u8(0xF9);            // idiv ecx
+    }
+
+    // jz to a fault stub emitted later; returns the rel32 position to patch.
+    size_t jz_forward() { u8(0x0F); u8(0x84); u32(0); return code.size() - 4; }
+    size_t jmp_forward() { u8(0xE9); u32(0); return code.size() - 4; }
+    void test_ecx_ecx() { u8(0x85); u8(0xC9); }
+
+    void patch_to_here(size_t rel32_at) {
+        uint32_t rel = static_cast<uint32_t>(code.size() - (rel32_at + 4));
+        std::memcpy(&code[rel32_at], &rel, 4);
+    }
+};
+
+// Walks the function starting at `target` and generates its code. Returns
+// false for anything the baseline tier does not handle.
+bool generate(const Program &program, uint32_t target, Assembler &as, JitFunction &fn) {
+    struct Fault { size_t rel32_at; uint32_t instruction; };
+    std::vector<Fault> faults;
+
+    int32_t depth = 0;        // Stack depth relative to entry.
+    bool tos_in_eax = false;  // Whether slot depth-1 currently lives in eax.
+    fn = {nullptr, 0, 0, 0, 0};
+
+    // Brings the top of stack into eax.
+    auto top_to_eax = [&]() {
+        if (!tos_in_eax) {
+            as.load_eax(depth - 1);
+            tos_in_eax = true;
+        }
+    };
+    auto pops = [&](int32_t n) {
+        if (depth - n < fn.min_depth) fn.min_depth = depth - n;
+    };
+
+    uint32_t index = target;
+    for (;;) {
+        if (++fn.length > JitCompiler::MAX_TRACE) {
+            return false; // Too long, or a jmp cycle that never returns.
+        }
+        const DecodedInstruction &instr = program.code[index];
+        switch (instr.op) {
+            case Opcode::ICONST:
+                if (tos_in_eax) as.store_eax(depth - 1);
+                as.mov_eax_imm(instr.operand);
+                tos_in_eax = true;
+                depth++;
+                if (depth > fn.max_depth) fn.max_depth = depth;
+                index++;
+                break;
+            case Opcode::IADD:
+            case Opcode::ISUB:
+            case Opcode::IMUL:
+            case Opcode::IDIV:
+                pops(2);
+                top_to_eax();                         // eax = b
+                if (instr.op == Opcode::IADD) {
+                    as.add_eax_slot(depth - 2);
+                } else if (instr.op == Opcode::IMUL) {
+                    as.imul_eax_slot(depth - 2);
+                } else if (instr.op == Opcode::ISUB) {
+                    as.load_ecx(depth - 2);
+                    as.xchg_eax_ecx();                // eax = a, ecx = b
+                    as.sub_eax_ecx();
+                } else {
+                    as.load_ecx(depth - 2);
+                    as.xchg_eax_ecx();
+                    as.test_ecx_ecx();
+                    faults.push_back({as.jz_forward(), index});
+                    as.idiv_eax_ecx();
+                }
+                depth--;
+                index++;
+                break;
+            case Opcode::ICONST_IADD:
+            case Opcode::ICONST_ISUB:
+            case Opcode::ICONST_IMUL:
+            case Opcode::ICONST_IDIV:
+                pops(1);
+                top_to_eax();
+                if (instr.op == Opcode::ICONST_IADD) {
+                    as.add_eax_imm(instr.operand);
+                } else if (instr.op == Opcode::ICONST_ISUB) {
+                    as.sub_eax_imm(instr.operand);
+                } else if (instr.op == Opcode::ICONST_IMUL) {
+                    as.imul_eax_imm(instr.operand);
+                } else if (instr.operand == 0) {
+                    faults.push_back({as.jmp_forward(), index});
+                } else {
+                    as.mov_ecx_imm(instr.operand);
+                    as.idiv_eax_ecx();
+                }
+                index++;
+                break;
+            case Opcode::JMP:
+                index = static_cast<uint32_t>(instr.operand);
+                break;
+            case Opcode::RET:
+                if (tos_in_eax) as.store_eax(depth - 1);
+                as.xor_eax_eax();
+                as.ret();
+                fn.ret_depth = depth;
+                for (const Fault &fault : faults) {
+                    as.patch_to_here(fault.rel32_at);
+                    as.mov_eax_imm(static_cast<int32_t>(fault.instruction + 1));
+                    as.ret();
+                }
+                return true;
+            default:
+                return false; // invoke, or running off the end of the code
+        }
+    }
+}
+
+} // namespace
+
+bool JitCompiler::supported() {
+#if defined(__x86_64__) && defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+JitCompiler::JitCompiler(const Program &program, uint32_t threshold)
+    : program(program), threshold(threshold ? threshold : 1),
+      counts(program.code.size(), 0), slots(program.code.size(), NOT_YET) {}
+
+JitCompiler::~JitCompiler() {
+    for (const auto &chunk : chunks) {
+        munmap(chunk.first, chunk.second);
+    }
+}
+
+const JitFunction *JitCompiler::compile(uint32_t target) {
+    Assembler as;
+    JitFunction fn;
+    if (!supported() || !generate(program, target, as, fn)) {
+        slots[target] = UNCOMPILABLE;
+        return nullptr;
+    }
+    fn.entry = reinterpret_cast<uint32_t (*)(int32_t *)>(install(as.code));
+    slots[target] = static_cast<int32_t>(functions.size());
+    functions.push_back(fn);
+    return &functions.back();
+}
+
+// Copies `code` into executable memory. Chunks are flipped to writable only
+// for the copy, so no page is ever writable and executable at once.
+uint8_t *JitCompiler::install(const std::vector<uint8_t> &code) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    if (chunks.empty() || chunk_used + code.size() > chunks.back().second) {
+        size_t size = std::max<size_t>(64 * 1024, (code.size() + page - 1) / page * page);
+        void *p = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            throw std::runtime_error("JIT: cannot allocate executable memory");
+        }
+        chunks.push_back({static_cast<uint8_t *>(p), size});
+        chunk_used = 0;
+    }
+    uint8_t *base = chunks.back().first;
+    size_t size = chunks.back().second;
+    if (mprotect(base, size, PROT_READ | PROT_WRITE) != 0) {
+        throw std::runtime_error("JIT: cannot make code memory writable");
+    }
+    uint8_t *entry = base + chunk_used;
+    std::memcpy(entry, code.data(), code.size());
+    chunk_used += (code.size() + 15) & ~size_t(15); // Keep entry points 16-byte aligned.
+    if (mprotect(base, size, PROT_READ | PROT_EXEC) != 0) {
+        throw std::runtime_error("JIT: cannot make code memory executable");
+    }
+    return entry;
+}
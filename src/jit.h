@@ -0,0 +1,79 @@
+// File: jit.h
+// Owner: Team
+// Role: Virtual Machine
+// Description: Baseline x86-64 JIT for hot functions. A compiled function runs
+//              directly on the interpreter's operand stack, so the two tiers can
+//              hand control back and forth at every invoke.
+
+#ifndef JIT_H
+#define JIT_H
+
+#include "vm.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Native code for one invoke target. Without invoke or any conditional branch
+// a function is a single straight-line trace (following its jmps) ending in
+// ret, so its stack effect is known at compile time, relative to the stack
+// pointer at entry.
+struct JitFunction
+{
+    // Runs the function on the operand stack whose top is `sp`, leaving the
+    // same stack contents the interpreter would. Returns 0, or 1 + the index of
+    // the instruction that divided by zero.
+    uint32_t (*entry)(int32_t *sp);
+    int32_t min_depth;   // Lowest stack depth the function pops down to (<= 0).
+    int32_t max_depth;   // Highest stack depth it pushes up to (>= 0).
+    int32_t ret_depth;   // Stack depth at its ret.
+    uint32_t length;     // Instructions on the trace, ret and jmps included.
+};
+
+// Compiles functions once they have been invoked `threshold` times, into
+// mmap'd memory that is writable only while code is being added. Functions
+// it cannot compile (any invoke, a jmp cycle, a trace longer than
+// MAX_TRACE) are remembered and stay interpreted.
+class JitCompiler {
+public:
+    static constexpr uint32_t MAX_TRACE = 4096;
+
+    JitCompiler(const Program &program, uint32_t threshold);
+    ~JitCompiler();
+    JitCompiler(const JitCompiler &) = delete;
+    JitCompiler &operator=(const JitCompiler &) = delete;
+
+    // True when this build can generate code for the host.
+    static bool supported();
+
+    // Counts one invocation of `target`; returns its compiled function once it
+    // is hot, or nullptr while it is (or must stay) interpreted.
+    const JitFunction *on_invoke(uint32_t target) {
+        int32_t slot = slots[target];
+        if (slot >= 0) {
+            return &functions[slot];
+        }
+        if (slot == NOT_YET && ++counts[target] >= threshold) {
+            return compile(target);
+        }
+        return nullptr;
+    }
+
+    size_t compiled() const { return functions.size(); }
+
+private:
+    static constexpr int32_t NOT_YET = -1;
+    static constexpr int32_t UNCOMPILABLE = -2;
+
+    const JitFunction *compile(uint32_t target);
+    uint8_t *install(const std::vector<uint8_t> &code);
+
+    const Program &program;
+    uint32_t threshold;
+    std::vector<uint32_t> counts;   // Invocations seen so far, per instruction index.
+    std::vector<int32_t> slots;     // Index into `functions`, or NOT_YET / UNCOMPILABLE.
+    std::vector<JitFunction> functions;
+    std::vector<std::pair<uint8_t *, size_t>> chunks; // Executable memory, newest last.
+    size_t chunk_used = 0;
+};
+
+#endif // JIT_H
@@ -0,0 +1,31 @@
+// File: lexer.cpp
+// Owner: Team
+// Role: Parser & Front-end
+// Description: Integer parsing for the lexer.
+
+#include "lexer.h"
+#include <charconv>
+#include <limits>
+
+int32_t parse_int32(std::string_view token)
+{
+    bool negative = false;
+    size_t i = 0;
+    if (!token.empty() && (token[0] == '+' || token[0] == '-'))
+    {
+        negative = token[0] == '-';
+        i = 1;
+    }
+    if (i == token.size() || token[i] < '0' || token[i] > '9')
+        return 0;
+
+    uint64_t magnitude = 0;
+    auto result = std::from_chars(token.data() + i, token.data() + token.size(), magnitude);
+    if (result.ec == std::errc::result_out_of_range)
+        magnitude = std::numeric_limits<uint64_t>::max();
+
+    if (negative)
+        return magnitude > 2147483648ULL ? std::numeric_limits<int32_t>::min()
+                                         : static_cast<int32_t>(-static_cast<int64_t>(magnitude));
+    return magnitude > 2147483647ULL ? std::numeric_limits<int32_t>::max() : static_cast<int32_t>(magnitude);
+}
@@ -0,0 +1,156 @@
+// File: lexer.h
+// Owner: Team
+// Role: Parser & Front-end
+// Description: Allocation-free scanning of .stkasm source held in one buffer:
+//              line splitting, comment stripping, tokenizing, keyword lookup
+//              through a compile-time perfect hash, and integer parsing.
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Every mnemonic and directive of the language.
+enum class Keyword : uint8_t
+{
+    NONE,
+    ICONST, IADD, ISUB, IMUL, IDIV, JMP, INVOKE, RET,
+    TEXT, DATA, GLOBAL, EXTERN, STATIC, ARRAY, SPACE, INCBIN
+};
+
+namespace keyword_detail
+{
+struct Entry
+{
+    std::string_view name;
+    Keyword keyword;
+};
+
+constexpr Entry KEYWORDS[] = {
+    {"iconst", Keyword::ICONST}, {"iadd", Keyword::IADD},     {"isub", Keyword::ISUB},
+    {"imul", Keyword::IMUL},     {"idiv", Keyword::IDIV},     {"jmp", Keyword::JMP},
+    {"invoke", Keyword::INVOKE}, {"ret", Keyword::RET},       {".text", Keyword::TEXT},
+    {".data", Keyword::DATA},    {".global", Keyword::GLOBAL}, {".extern", Keyword::EXTERN},
+    {".static", Keyword::STATIC}, {".array", Keyword::ARRAY},  {".space", Keyword::SPACE},
+    {".incbin", Keyword::INCBIN},
+};
+constexpr size_t TABLE_SIZE = 32;
+
+// Collision-free over KEYWORDS (checked below); every keyword is >= 3 chars.
+constexpr size_t hash(std::string_view word)
+{
+    return (word.size() + static_cast<unsigned char>(word[2]) * 4 +
+            static_cast<unsigned char>(word[word.size() - 1]) * 23) & (TABLE_SIZE - 1);
+}
+
+struct Table
+{
+    Entry slots[TABLE_SIZE] = {};
+};
+
+constexpr Table build_table()
+{
+    Table table;
+    for (const Entry &entry : KEYWORDS)
+        table.slots[hash(entry.name)] = entry;
+    return table;
+}
+
+constexpr Table TABLE = build_table();
+
+constexpr bool is_perfect()
+{
+    for (const Entry &entry : KEYWORDS)
+        if (TABLE.slots[hash(entry.name)].keyword != entry.keyword)
+            return false;
+    return true;
+}
+static_assert(is_perfect(), "keyword hash has a collision; pick new multipliers");
+} // namespace keyword_detail
+
+// Maps a mnemonic or directive to its Keyword with one hash and one compare.
+constexpr Keyword lookup_keyword(std::string_view word)
+{
+    if (word.size() < 3)
+        return Keyword::NONE;
+    const keyword_detail::Entry &slot = keyword_detail::TABLE.slots[keyword_detail::hash(word)];
+    return slot.name == word ? slot.keyword : Keyword::NONE;
+}
+
+// Yields the lines of a buffer as views, split on '\n' like std::getline.
+// Each line has its '#' comment removed and is trimmed of " \t\n\r".
+class LineScanner
+{
+public:
+    explicit LineScanner(std::string_view buffer) : pos(buffer.data()), end(buffer.data() + buffer.size()) {}
+
+    // Returns false at end of input.
+    bool next(std::string_view &line)
+    {
+        if (pos == end)
+            return false;
+        const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        const char *line_end = newline ? newline : end;
+        const char *hash_mark = static_cast<const char *>(std::memchr(pos, '#', line_end - pos));
+        const char *first = pos;
+        const char *last = hash_mark ? hash_mark : line_end;
+        pos = newline ? newline + 1 : end;
+
+        while (first < last && is_trimmed(*first))
+            first++;
+        while (last > first && is_trimmed(last[-1]))
+            last--;
+        line = std::string_view(first, last - first);
+        return true;
+    }
+
+private:
+    static bool is_trimmed(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    const char *pos;
+    const char *end;
+};
+
+// Splits a line into whitespace-separated tokens, as `istream >> std::string`
+// would; an exhausted cursor yields empty tokens.
+class TokenCursor
+{
+public:
+    explicit TokenCursor(std::string_view text) : rest(text) {}
+
+    std::string_view next()
+    {
+        size_t i = 0;
+        while (i < rest.size() && is_space(rest[i]))
+            i++;
+        size_t start = i;
+        while (i < rest.size() && !is_space(rest[i]))
+            i++;
+        std::string_view token = rest.substr(start, i - start);
+        rest.remove_prefix(i);
+        return token;
+    }
+
+    // Everything after the tokens read so far, without leading whitespace.
+    std::string_view remainder()
+    {
+        while (!rest.empty() && is_space(rest[0]))
+            rest.remove_prefix(1);
+        return rest;
+    }
+
+private:
+    static bool is_space(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+    std::string_view rest;
+};
+
+// Reads a decimal integer prefix of `token` the way `istream >> int32_t` does:
+// an optional sign, digits up to the first non-digit, saturation on overflow,
+// and 0 when there are no digits.
+int32_t parse_int32(std::string_view token);
+
+#endif // LEXER_H
@@ -0,0 +1,264 @@
+// File: link_gc.cpp
+// Owner: Team
+// Role: Linker Dead-Code Elimination
+// Description: Marks functions and data entries reachable from the roots with a
+//              worklist over the decoded code, then computes each object's
+//              compacted layout in parallel.
+
+#include "link_gc.h"
+#include "byte_io.h"
+#include "opcodes.h"
+#include <algorithm>
+#include <string>
+
+uint32_t GcObjectLayout::map_offset(const std::vector<GcPiece> &pieces, uint32_t offset) {
+    auto it = std::upper_bound(pieces.begin(), pieces.end(), offset,
+                               [](uint32_t value, const GcPiece &piece) { return value < piece.begin; });
+    if (it == pieces.begin()) return GC_REMOVED;
+    --it;
+    return offset <= it->end ? it->new_begin + (offset - it->begin) : GC_REMOVED;
+}
+
+namespace {
+
+// Where one object's functions and data entries start. Functions and entries
+// get global ids in input order, so function id + 1 is always the code that
+// follows in the linked image.
+struct ObjectIndex {
+    std::vector<uint32_t> functions; // First code byte of each function, ascending; [0] == 0.
+    std::vector<uint32_t> entries;   // First byte of each data entry, ascending; [0] == 0.
+    uint32_t first_function = 0;
+    uint32_t first_entry = 0;
+};
+
+// Label addresses below `size` plus 0, sorted and deduplicated; empty for an empty section.
+std::vector<uint32_t> starts_from(std::vector<uint32_t> labels, uint32_t size) {
+    if (size == 0) return {};
+    labels.push_back(0);
+    labels.erase(std::remove_if(labels.begin(), labels.end(), [&](uint32_t a) { return a >= size; }), labels.end());
+    std::sort(labels.begin(), labels.end());
+    labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+    return labels;
+}
+
+// Index of the range in `starts` holding `value`; `starts` begins at 0.
+uint32_t range_of(const std::vector<uint32_t> &starts, uint32_t value) {
+    return static_cast<uint32_t>(std::upper_bound(starts.begin(), starts.end(), value) - starts.begin() - 1);
+}
+
+class Collector {
+public:
+    Collector(const std::vector<ParsedObjectFile> &objects, const SymbolTable &globals,
+              const std::vector<uint32_t> &defined_in)
+        : objects(objects), globals(globals), defined_in(defined_in), index(objects.size()) {}
+
+    void build_index(ThreadPool &pool) {
+        pool.parallel_for(objects.size(), [&](size_t i) {
+            const ParsedObjectFile &obj = objects[i];
+            ObjectIndex &ix = index[i];
+            std::vector<uint32_t> text, data;
+            for (const auto &sym : obj.symbol_table) {
+                if (sym.type == Symbol::Type::TEXT) text.push_back(sym.address);
+                if (sym.type == Symbol::Type::DATA) data.push_back(sym.address);
+            }
+            ix.functions = starts_from(std::move(text), obj.code_size);
+            ix.entries = starts_from(std::move(data), obj.data_size);
+        });
+        for (size_t i = 0; i < objects.size(); i++) {
+            index[i].first_function = static_cast<uint32_t>(function_object.size());
+            index[i].first_entry = static_cast<uint32_t>(entry_object.size());
+            function_object.insert(function_object.end(), index[i].functions.size(), static_cast<uint32_t>(i));
+            entry_object.insert(entry_object.end(), index[i].entries.size(), static_cast<uint32_t>(i));
+        }
+        live_functions.assign(function_object.size(), 0);
+        live_entries.assign(entry_object.size(), 0);
+    }
+
+    void mark(const std::vector<SymbolId> &roots) {
+        for (SymbolId root : roots) reach_symbol(root);
+        while (!work.empty()) {
+            uint32_t function = work.back();
+            work.pop_back();
+            scan(function);
+        }
+    }
+
+    GcResult layout(ThreadPool &pool) {
+        GcResult result;
+        result.objects.resize(objects.size());
+        std::vector<std::vector<GcRemoved>> removed(objects.size());
+        pool.parallel_for(objects.size(), [&](size_t i) { layout_object(i, result.objects[i], removed[i]); });
+
+        GcReport &report = result.report;
+        report.functions = function_object.size();
+        report.data_entries = entry_object.size();
+        for (size_t i = 0; i < objects.size(); i++) {
+            report.code_bytes_removed += objects[i].code_size - result.objects[i].code_size;
+            report.data_bytes_removed += objects[i].data_size - result.objects[i].data_size;
+            for (GcRemoved &r : removed[i]) {
+                (r.code ? report.functions_removed : report.data_entries_removed)++;
+                report.removed.push_back(std::move(r));
+            }
+        }
+        std::stable_sort(report.removed.begin(), report.removed.end(),
+                         [](const GcRemoved &a, const GcRemoved &b) { return a.bytes > b.bytes; });
+        return result;
+    }
+
+private:
+    // The function holding code byte `offset` of object `i`. A target just past
+    // the object's last instruction is the next object's first function.
+    uint32_t function_at(size_t i, uint32_t offset) const {
+        const ObjectIndex &ix = index[i];
+        if (offset >= objects[i].code_size) {
+            uint32_t next = ix.first_function + static_cast<uint32_t>(ix.functions.size());
+            return next < function_object.size() ? next : GC_REMOVED;
+        }
+        return ix.first_function + range_of(ix.functions, offset);
+    }
+
+    void reach_function(uint32_t id) {
+        if (id == GC_REMOVED || live_functions[id]) return;
+        live_functions[id] = 1;
+        work.push_back(id);
+    }
+
+    void reach_symbol(SymbolId id) {
+        const Symbol &sym = globals[id];
+        size_t i = defined_in[id];
+        if (sym.type == Symbol::Type::TEXT) {
+            reach_function(function_at(i, sym.address));
+        } else if (sym.type == Symbol::Type::DATA && sym.address < objects[i].data_size) {
+            live_entries[index[i].first_entry + range_of(index[i].entries, sym.address)] = 1;
+        }
+    }
+
+    // Follows every branch in a live function, and its fall-through. Branch
+    // targets were checked to be in range when the object was loaded.
+    void scan(uint32_t function) {
+        size_t i = function_object[function];
+        const ParsedObjectFile &obj = objects[i];
+        uint32_t begin, end;
+        function_bounds(i, function - index[i].first_function, begin, end);
+        Opcode last = Opcode::RET;
+        for (uint32_t offset = begin; offset < end; offset += encoded_size(static_cast<Opcode>(obj.code[offset]))) {
+            Opcode op = static_cast<Opcode>(obj.code[offset]);
+            last = long_form(op);
+            if (is_relative_branch(op)) {
+                uint32_t target = offset + encoded_size(op) + decode_instruction(obj.code + offset).operand;
+                reach_function(function_at(i, target));
+                continue;
+            }
+            if (!is_branch(op)) continue;
+            uint32_t site = offset + 1;
+            auto reloc = std::lower_bound(obj.relocation_table.begin(), obj.relocation_table.end(), site,
+                                          [](const ObjectRelocation &r, uint32_t value) { return r.offset < value; });
+            if (reloc != obj.relocation_table.end() && reloc->offset == site) {
+                SymbolId target = globals.find(obj.symbol_table[reloc->symbol].name);
+                if (target != NO_SYMBOL) reach_symbol(target);
+                continue;
+            }
+            reach_function(function_at(i, obj.local_target(site)));
+        }
+        if (last != Opcode::RET && last != Opcode::JMP) {
+            reach_function(function + 1 < function_object.size() ? function + 1 : GC_REMOVED);
+        }
+    }
+
+    // Byte range of function `k` of object `i`.
+    void function_bounds(size_t i, size_t k, uint32_t &begin, uint32_t &end) const {
+        const std::vector<uint32_t> &functions = index[i].functions;
+        begin = functions[k];
+        end = k + 1 < functions.size() ? functions[k + 1] : objects[i].code_size;
+    }
+
+    // Names each function or entry after its first label, preferring a global one.
+    static void name_ranges(const ParsedObjectFile &obj, Symbol::Type type, const std::vector<uint32_t> &starts,
+                            std::vector<std::string> &names) {
+        std::vector<char> global(starts.size(), 0);
+        for (const auto &sym : obj.symbol_table) {
+            if (sym.type != type) continue;
+            auto it = std::lower_bound(starts.begin(), starts.end(), sym.address);
+            if (it == starts.end() || *it != sym.address) continue;
+            size_t k = static_cast<size_t>(it - starts.begin());
+            bool is_global = sym.binding == Symbol::Binding::GLOBAL;
+            if (names[k].empty() || (is_global && !global[k])) {
+                names[k] = std::string(sym.name);
+                global[k] = is_global;
+            }
+        }
+    }
+
+    // Appends a surviving range to a section's pieces.
+    static void keep(std::vector<GcPiece> &pieces, uint32_t &size, uint32_t begin, uint32_t end) {
+        if (!pieces.empty() && pieces.back().end == begin) { // Kept pieces are packed, so this extends the last one.
+            pieces.back().end = end;
+        } else {
+            pieces.push_back({begin, end, size});
+        }
+        size += end - begin;
+    }
+
+    void layout_object(size_t i, GcObjectLayout &out, std::vector<GcRemoved> &removed) const {
+        const ParsedObjectFile &obj = objects[i];
+        const ObjectIndex &ix = index[i];
+
+        std::vector<std::string> names(ix.functions.size());
+        name_ranges(obj, Symbol::Type::TEXT, ix.functions, names);
+        out.source_code_size = obj.code_size;
+        for (size_t k = 0; k < ix.functions.size(); k++) {
+            uint32_t begin, end;
+            function_bounds(i, k, begin, end);
+            if (!live_functions[ix.first_function + k]) {
+                std::string name = names[k].empty() ? "(code at offset " + std::to_string(begin) + ")" : names[k];
+                removed.push_back({name, obj.path, true, end - begin});
+                continue;
+            }
+            keep(out.code, out.code_size, begin, end);
+        }
+        // Short branches stay in range: kept code only moves closer together.
+        for (const GcPiece &piece : out.code) {
+            for (uint32_t offset = piece.begin; offset < piece.end; offset += encoded_size(static_cast<Opcode>(obj.code[offset]))) {
+                Opcode op = static_cast<Opcode>(obj.code[offset]);
+                if (is_relative_branch(op)) {
+                    uint32_t target = offset + encoded_size(op) + decode_instruction(obj.code + offset).operand;
+                    out.relative_branches.push_back({piece.new_begin + (offset - piece.begin), out.code_target(target)});
+                }
+            }
+        }
+
+        names.assign(ix.entries.size(), std::string());
+        name_ranges(obj, Symbol::Type::DATA, ix.entries, names);
+        for (size_t k = 0; k < ix.entries.size(); k++) {
+            uint32_t begin = ix.entries[k];
+            uint32_t end = k + 1 < ix.entries.size() ? ix.entries[k + 1] : obj.data_size;
+            if (!live_entries[ix.first_entry + k]) {
+                std::string name = names[k].empty() ? "(data at offset " + std::to_string(begin) + ")" : names[k];
+                removed.push_back({name, obj.path, false, end - begin});
+                continue;
+            }
+            keep(out.data, out.data_size, begin, end);
+        }
+    }
+
+    const std::vector<ParsedObjectFile> &objects;
+    const SymbolTable &globals;
+    const std::vector<uint32_t> &defined_in;
+    std::vector<ObjectIndex> index;
+    std::vector<uint32_t> function_object; // Function id -> object index.
+    std::vector<uint32_t> entry_object;    // Data entry id -> object index.
+    std::vector<char> live_functions;
+    std::vector<char> live_entries;
+    std::vector<uint32_t> work;
+};
+
+} // namespace
+
+GcResult collect_garbage(const std::vector<ParsedObjectFile> &objects, const SymbolTable &globals,
+                         const std::vector<uint32_t> &defined_in, const std::vector<SymbolId> &roots,
+                         ThreadPool &pool) {
+    Collector collector(objects, globals, defined_in);
+    collector.build_index(pool);
+    collector.mark(roots);
+    return collector.layout(pool);
+}
@@ -0,0 +1,99 @@
+// File: link_gc.h
+// Owner: Team
+// Role: Linker Dead-Code Elimination
+// Description: Reachability analysis for `linker --gc`. Each object's code is split
+//              into functions at its TEXT labels and its data into entries at its DATA
+//              labels. A function survives if the roots reach it through jmp/invoke
+//              targets (local branches or relocations) or by falling through into it;
+//              a data entry survives if a surviving relocation or a root names it.
+//              Survivors are packed in their original order.
+
+#ifndef LINK_GC_H
+#define LINK_GC_H
+
+#include "object_file.h"
+#include "symbol_table.h"
+#include "thread_pool.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr uint32_t GC_REMOVED = UINT32_MAX;
+
+// A run of bytes kept from one section of an object, and where it lands once
+// the section is compacted.
+struct GcPiece
+{
+    uint32_t begin;     // Byte offset in the object's section.
+    uint32_t end;
+    uint32_t new_begin; // Byte offset in the compacted section.
+};
+
+// A surviving short (relative) branch, whose displacement must be rewritten
+// for the compacted code.
+struct GcBranch
+{
+    uint32_t new_offset; // Of the instruction, in the compacted code section.
+    uint32_t new_target;
+};
+
+// How one object's sections shrink.
+struct GcObjectLayout
+{
+    std::vector<GcPiece> code;
+    std::vector<GcPiece> data;
+    std::vector<GcBranch> relative_branches;
+    uint32_t code_size = 0;         // After removal.
+    uint32_t data_size = 0;
+    uint32_t source_code_size = 0;  // Before removal.
+
+    // Maps a byte offset within the code or data section, or returns GC_REMOVED
+    // if it was dropped. An offset at the end of a kept piece maps to its new end.
+    uint32_t code_offset(uint32_t offset) const { return map_offset(code, offset); }
+    uint32_t data_offset(uint32_t offset) const { return map_offset(data, offset); }
+    // Like code_offset for a code address, except that the end of the section
+    // (where execution falls into the next object) maps to its new end.
+    uint32_t code_target(uint32_t offset) const {
+        return offset == source_code_size ? code_size : code_offset(offset);
+    }
+
+private:
+    static uint32_t map_offset(const std::vector<GcPiece> &pieces, uint32_t offset);
+};
+
+// One function or data entry that was dropped, for the size report.
+struct GcRemoved
+{
+    std::string name;   // Its first label, preferring a global one.
+    std::string object; // Path of the object it came from.
+    bool code;          // Function rather than data entry.
+    uint32_t bytes;
+};
+
+// What --gc removed, summed over every input.
+struct GcReport
+{
+    size_t functions = 0;
+    size_t functions_removed = 0;
+    size_t data_entries = 0;
+    size_t data_entries_removed = 0;
+    uint64_t code_bytes_removed = 0;
+    uint64_t data_bytes_removed = 0;
+    std::vector<GcRemoved> removed;      // Largest first.
+};
+
+struct GcResult
+{
+    std::vector<GcObjectLayout> objects; // Parallel to the inputs.
+    GcReport report;
+};
+
+// Finds everything reachable from `roots`. `globals` holds every global
+// definition at its object-relative address, and defined_in[id] is the index
+// of the object defining global `id`. Relocations to names missing from
+// `globals` are not followed (the linker reports them if they survive).
+GcResult collect_garbage(const std::vector<ParsedObjectFile> &objects, const SymbolTable &globals,
+                         const std::vector<uint32_t> &defined_in, const std::vector<SymbolId> &roots,
+                         ThreadPool &pool);
+
+#endif // LINK_GC_H
@@ -0,0 +1,136 @@
+// File: link_map.cpp
+// Owner: Rashmitha
+// Role: Incremental Linking
+// Description: Reading and writing the binary link map.
+
+#include "link_map.h"
+#include "byte_io.h"
+#include "mapped_file.h"
+#include <cstdio>
+#include <stdexcept>
+#include <sys/stat.h>
+
+bool FileStamp::of(const std::string &path, FileStamp &stamp) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    stamp.size = static_cast<uint64_t>(st.st_size);
+    stamp.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    stamp.inode = static_cast<uint64_t>(st.st_ino);
+    return true;
+}
+
+static void write_stamp(ByteWriter &out, const FileStamp &stamp) {
+    out.u64(stamp.size);
+    out.u64(static_cast<uint64_t>(stamp.mtime_ns));
+    out.u64(stamp.inode);
+}
+
+static FileStamp read_stamp(ByteReader &in) {
+    FileStamp stamp;
+    stamp.size = in.u64();
+    stamp.mtime_ns = static_cast<int64_t>(in.u64());
+    stamp.inode = in.u64();
+    return stamp;
+}
+
+void LinkMap::write(const std::string &path) const {
+    ByteWriter out;
+    out.u32(LINK_MAP_MAGIC);
+    out.u32(LINK_MAP_VERSION);
+    out.string(entry);
+    out.u32(entry_global);
+    out.u32(code_size);
+    out.u32(data_size);
+    write_stamp(out, output);
+
+    out.u32(static_cast<uint32_t>(objects.size()));
+    for (const auto &obj : objects) {
+        out.string(obj.path);
+        write_stamp(out, obj.stamp);
+        out.u64(obj.hash);
+        out.u32(obj.code_offset);
+        out.u32(obj.code_size);
+        out.u32(obj.data_offset);
+        out.u32(obj.data_size);
+    }
+    out.u32(static_cast<uint32_t>(globals.size()));
+    for (const auto &global : globals) {
+        out.string(global.name);
+        out.u8(static_cast<uint8_t>(global.type));
+        out.u32(global.address);
+        out.u32(global.object);
+    }
+    out.u32(static_cast<uint32_t>(sites.size()));
+    for (const auto &site : sites) {
+        out.u32(site.code_offset);
+        out.u32(site.global);
+        out.u32(site.object);
+    }
+
+    // Write beside the target and rename, so a crash never leaves a torn map.
+    std::string temp = path + ".tmp";
+    std::FILE *file = std::fopen(temp.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot write link map: " + temp);
+    }
+    bool ok = std::fwrite(out.bytes.data(), 1, out.bytes.size(), file) == out.bytes.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        throw std::runtime_error("Cannot write link map: " + path);
+    }
+}
+
+bool LinkMap::read(const std::string &path, LinkMap &map) {
+    try {
+        MappedFile file = MappedFile::open_read(path);
+        ByteReader in(file.data(), file.size(), path);
+        if (in.u32() != LINK_MAP_MAGIC || in.u32() != LINK_MAP_VERSION) {
+            return false;
+        }
+        map = LinkMap();
+        map.entry = std::string(in.string());
+        map.entry_global = in.u32();
+        map.code_size = in.u32();
+        map.data_size = in.u32();
+        map.output = read_stamp(in);
+
+        // Every record is at least 4 bytes, which bounds the counts by the file size.
+        auto count = [&in]() {
+            uint32_t n = in.u32();
+            if (n > in.remaining() / 4) throw std::runtime_error("bad count");
+            return n;
+        };
+        map.objects.resize(count());
+        for (auto &obj : map.objects) {
+            obj.path = std::string(in.string());
+            obj.stamp = read_stamp(in);
+            obj.hash = in.u64();
+            obj.code_offset = in.u32();
+            obj.code_size = in.u32();
+            obj.data_offset = in.u32();
+            obj.data_size = in.u32();
+        }
+        map.globals.resize(count());
+        for (auto &global : map.globals) {
+            global.name = std::string(in.string());
+            global.type = static_cast<Symbol::Type>(in.u8());
+            global.address = in.u32();
+            global.object = in.u32();
+        }
+        map.sites.resize(count());
+        for (auto &site : map.sites) {
+            site.code_offset = in.u32();
+            site.global = in.u32();
+            site.object = in.u32();
+            if (site.global >= map.globals.size() || site.object >= map.objects.size()) {
+                return false;
+            }
+        }
+        return map.entry_global < map.globals.size();
+    } catch (const std::exception &) {
+        return false;
+    }
+}
@@ -0,0 +1,72 @@
+// File: link_map.h
+// Owner: Rashmitha
+// Role: Incremental Linking
+// Description: The sidecar link map (<output>.map) written next to an incrementally
+//              linked executable. It records where every object landed, the resolved
+//              global addresses and every relocation site, so a later link can patch
+//              only what changed.
+
+#ifndef LINK_MAP_H
+#define LINK_MAP_H
+
+#include "symbol_table.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr uint32_t LINK_MAP_MAGIC = 0x4D4C5453; // "STLM"
+constexpr uint32_t LINK_MAP_VERSION = 2;
+
+// Identity of a file on disk, cheap to compare before falling back to hashing.
+struct FileStamp
+{
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    uint64_t inode = 0;
+
+    // Returns false if the file cannot be stat'ed.
+    static bool of(const std::string &path, FileStamp &stamp);
+    bool operator==(const FileStamp &other) const {
+        return size == other.size && mtime_ns == other.mtime_ns && inode == other.inode;
+    }
+};
+
+struct LinkMap
+{
+    struct Object
+    {
+        std::string path;
+        FileStamp stamp;
+        uint64_t hash = 0; // ContentHash of the object file bytes.
+        uint32_t code_offset = 0, code_size = 0;
+        uint32_t data_offset = 0, data_size = 0;
+    };
+    struct Global
+    {
+        std::string name;
+        Symbol::Type type;
+        uint32_t address = 0;
+        uint32_t object = 0; // Defining object.
+    };
+    struct Site
+    {
+        uint32_t code_offset = 0; // Within the final code section.
+        uint32_t global = 0;      // Index into globals.
+        uint32_t object = 0;      // Object whose code contains the site.
+    };
+
+    std::string entry;
+    uint32_t entry_global = 0;
+    uint32_t code_size = 0;
+    uint32_t data_size = 0;
+    FileStamp output;
+    std::vector<Object> objects;
+    std::vector<Global> globals;
+    std::vector<Site> sites;
+
+    void write(const std::string &path) const;
+    // Returns false if the map is missing, malformed or from another version.
+    static bool read(const std::string &path, LinkMap &map);
+};
+
+#endif // LINK_MAP_H
@@ -0,0 +1,614 @@
+// File: linker.cpp
+// Owner: Rashmitha
+// Role: Linker Core Logic
+// Description: Implementation of symbol resolution, section merging and relocation.
+//              Inputs are memory-mapped, and every object's sections are copied and
+//              patched in parallel straight into a presized, mapped output file.
+//              With LinkOptions::incremental, a link map is kept beside the output so
+//              that later links only rewrite the objects that changed. With
+//              LinkOptions::gc, unreachable functions and data are dropped first.
+
+#include "linker.h"
+#include "archive.h"
+#include "byte_io.h"
+#include "content_hash.h"
+#include "link_gc.h"
+#include "link_map.h"
+#include "mapped_file.h"
+#include "object_file.h"
+#include "opcodes.h"
+#include "stak_image.h"
+#include "symbol_table.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <unordered_set>
+
+static uint64_t hash_object(const ParsedObjectFile &obj) {
+    ContentHash hash;
+    hash.update(obj.file_data(), obj.file_size());
+    return hash.digest();
+}
+
+// Copies one object's sections into the image and rebases its local branches.
+static void place_object(const ParsedObjectFile &obj, uint8_t *code, uint8_t *data, uint32_t code_base) {
+    std::copy(obj.code, obj.code + obj.code_size, code);
+    obj.copy_data(0, obj.data_size, data);
+    for (uint32_t site : obj.local_branch_sites) {
+        write_u32(code + site, obj.local_target(site) + code_base);
+    }
+}
+
+// Copies the surviving pieces of one object's sections into the image,
+// rebases the long local branches in them and re-aims the short ones, whose
+// distance can only have shrunk.
+static void place_object_gc(const ParsedObjectFile &obj, const GcObjectLayout &layout, uint8_t *code, uint8_t *data,
+                            uint32_t code_base) {
+    for (const GcPiece &piece : layout.code) {
+        std::copy(obj.code + piece.begin, obj.code + piece.end, code + piece.new_begin);
+    }
+    for (const GcPiece &piece : layout.data) {
+        obj.copy_data(piece.begin, piece.end, data + piece.new_begin);
+    }
+    for (uint32_t site : obj.local_branch_sites) {
+        uint32_t new_site = layout.code_offset(site);
+        if (new_site != GC_REMOVED) {
+            write_u32(code + new_site, layout.code_target(obj.local_target(site)) + code_base);
+        }
+    }
+    for (const GcBranch &branch : layout.relative_branches) {
+        uint8_t *at = code + branch.new_offset;
+        Opcode op = static_cast<Opcode>(*at);
+        int32_t displacement = static_cast<int32_t>(branch.new_target - (branch.new_offset + encoded_size(op)));
+        at[1] = static_cast<uint8_t>(displacement);
+        if (op == Opcode::JMP16 || op == Opcode::INVOKE16) {
+            at[2] = static_cast<uint8_t>(displacement >> 8);
+        }
+    }
+}
+
+// Looks up each relocation target among the globals once per symbol rather
+// than once per site; entries for symbols no relocation uses stay NO_SYMBOL.
+static std::vector<SymbolId> resolve_targets(const ParsedObjectFile &obj, const SymbolTable &globals) {
+    std::vector<SymbolId> targets(obj.symbol_table.size(), NO_SYMBOL);
+    std::vector<char> looked_up(obj.symbol_table.size(), 0);
+    for (const auto &reloc : obj.relocation_table) {
+        if (!looked_up[reloc.symbol]) {
+            looked_up[reloc.symbol] = 1;
+            targets[reloc.symbol] = globals.find(obj.symbol_table[reloc.symbol].name);
+        }
+    }
+    return targets;
+}
+
+static std::string undefined_symbol(const ParsedObjectFile &obj, const ObjectRelocation &reloc) {
+    return "Undefined symbol '" + std::string(obj.symbol_table[reloc.symbol].name) + "' referenced from " + obj.path;
+}
+
+static void write_header(uint8_t *image, uint32_t entry_point, uint32_t code_size, uint32_t data_size) {
+    write_u32(image, STAK_MAGIC);
+    write_u32(image + 4, entry_point);
+    write_u32(image + 8, code_size);
+    write_u32(image + 12, data_size);
+}
+
+static std::string map_path_for(const std::string &output) {
+    return output + ".map";
+}
+
+static std::string symbols_path_for(const std::string &output) {
+    return output + ".sym";
+}
+
+// Writes the --symbols file; see link_objects. With `gc`, dropped symbols are left out.
+static void write_symbol_file(const std::string &path, const std::vector<ParsedObjectFile> &objects,
+                              const std::vector<uint32_t> &code_offsets, const std::vector<uint32_t> &data_offsets,
+                              uint32_t total_code, const GcResult *gc) {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    for (size_t i = 0; i < objects.size(); i++) {
+        for (const auto &sym : objects[i].symbol_table) {
+            if (sym.type == Symbol::Type::EXTERN) {
+                continue;
+            }
+            bool code = sym.type == Symbol::Type::TEXT;
+            uint32_t address = sym.address;
+            if (gc) {
+                address = code ? gc->objects[i].code_target(address) : gc->objects[i].data_offset(address);
+                if (address == GC_REMOVED) {
+                    continue;
+                }
+            }
+            address += code ? code_offsets[i] : total_code + data_offsets[i];
+            char type = code ? 'T' : 'D';
+            if (sym.binding == Symbol::Binding::LOCAL) {
+                type = static_cast<char>(type - 'A' + 'a');
+            }
+            std::fprintf(file, "%08x %c %.*s\n", address, type, static_cast<int>(sym.name.size()), sym.name.data());
+        }
+    }
+    if (std::fclose(file) != 0) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+// Maps every input. Object files are parsed now; archives only have their
+// header checked, and their members are parsed when they are pulled in.
+static void load_inputs(const std::vector<std::string> &inputs, ThreadPool &pool,
+                        std::vector<ParsedObjectFile> &objects, std::vector<Archive> &archives) {
+    std::vector<ParsedObjectFile> parsed(inputs.size());
+    std::vector<Archive> opened(inputs.size());
+    std::vector<char> is_archive(inputs.size(), 0);
+    std::vector<std::string> errors(inputs.size());
+    pool.parallel_for(inputs.size(), [&](size_t i) {
+        try {
+            auto file = std::make_shared<const MappedFile>(MappedFile::open_read(inputs[i]));
+            if (Archive::is_archive(file->data(), file->size())) {
+                opened[i] = Archive::from_mapping(std::move(file), inputs[i]);
+                is_archive[i] = 1;
+            } else {
+                size_t size = file->size();
+                parsed[i] = ParsedObjectFile::from_mapping(std::move(file), 0, size, inputs[i]);
+            }
+        } catch (const std::exception &e) {
+            errors[i] = e.what();
+        }
+    });
+    for (const auto &error : errors) {
+        if (!error.empty()) throw std::runtime_error(error);
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (is_archive[i]) {
+            archives.push_back(std::move(opened[i]));
+        } else {
+            objects.push_back(std::move(parsed[i]));
+        }
+    }
+}
+
+// Pulls in the archive members that define a symbol the objects reference (or
+// the entry point or a --keep root) without defining it, then does the same
+// for what those members reference, until nothing new is needed. Only the
+// archive indexes are consulted; each symbol comes from the first archive on
+// the command line that defines it. Members are appended to `objects` in the
+// order they are pulled in. Returns how many were.
+static size_t pull_archive_members(std::vector<ParsedObjectFile> &objects, const std::vector<Archive> &archives,
+                                   const LinkOptions &options, ThreadPool &pool) {
+    std::unordered_set<std::string_view> defined, requested;
+    std::vector<std::string_view> wanted;
+    auto want = [&](std::string_view name) {
+        if (!defined.count(name) && requested.insert(name).second) wanted.push_back(name);
+    };
+    want(options.entry);
+    for (const std::string &name : options.keep) want(name);
+
+    std::vector<std::vector<char>> loaded(archives.size());
+    for (size_t a = 0; a < archives.size(); a++) loaded[a].assign(archives[a].member_count(), 0);
+    size_t scanned = 0, pulled = 0;
+    for (;;) {
+        // Definitions first, so references between the new objects are not looked up.
+        for (size_t i = scanned; i < objects.size(); i++) {
+            for (const auto &sym : objects[i].symbol_table) {
+                if (sym.binding == Symbol::Binding::GLOBAL && sym.type != Symbol::Type::EXTERN) defined.insert(sym.name);
+            }
+        }
+        for (size_t i = scanned; i < objects.size(); i++) {
+            for (const auto &reloc : objects[i].relocation_table) want(objects[i].symbol_table[reloc.symbol].name);
+        }
+        scanned = objects.size();
+
+        std::vector<std::pair<size_t, uint32_t>> batch; // Archive, member.
+        for (std::string_view name : wanted) {
+            if (defined.count(name)) continue;
+            for (size_t a = 0; a < archives.size(); a++) {
+                uint32_t member = archives[a].find(name);
+                if (member == NO_MEMBER) continue;
+                if (!loaded[a][member]) {
+                    loaded[a][member] = 1;
+                    batch.push_back({a, member});
+                }
+                break;
+            }
+        }
+        wanted.clear();
+        if (batch.empty()) return pulled;
+
+        size_t base = objects.size();
+        objects.resize(base + batch.size());
+        std::vector<std::string> errors(batch.size());
+        pool.parallel_for(batch.size(), [&](size_t k) {
+            try {
+                objects[base + k] = archives[batch[k].first].load_member(batch[k].second);
+            } catch (const std::exception &e) {
+                errors[k] = e.what();
+            }
+        });
+        for (const auto &error : errors) {
+            if (!error.empty()) throw std::runtime_error(error);
+        }
+        pulled += batch.size();
+    }
+}
+
+static LinkResult full_link(const std::vector<std::string> &inputs, const std::string &output,
+                            const LinkOptions &options, ThreadPool &pool) {
+    // 1. Map and parse every object file, plus the archive members it needs.
+    std::vector<ParsedObjectFile> objects;
+    std::vector<Archive> archives;
+    load_inputs(inputs, pool, objects, archives);
+    size_t archive_members = 0;
+    for (const Archive &archive : archives) archive_members += archive.member_count();
+    size_t members_loaded = archives.empty() ? 0 : pull_archive_members(objects, archives, options, pool);
+    std::vector<std::string> errors(objects.size());
+
+    // 2. Build the global symbol table (hashed, in input order so duplicates are reported
+    // deterministically). Addresses stay object-relative until the layout is known.
+    SymbolTable globals;
+    std::vector<uint32_t> defined_in;
+    for (size_t i = 0; i < objects.size(); i++) {
+        for (const auto &sym : objects[i].symbol_table) {
+            if (sym.binding != Symbol::Binding::GLOBAL || sym.type == Symbol::Type::EXTERN) {
+                continue; // Locals are never referenced externally; externs are not definitions.
+            }
+            if (globals.add(sym.name, sym.type, sym.address) == NO_SYMBOL) {
+                SymbolId first = globals.find(sym.name);
+                throw std::runtime_error("Duplicate definition of global symbol '" + std::string(sym.name) +
+                                         "' in " + objects[i].path + " (first defined in " +
+                                         objects[defined_in[first]].path + ")");
+            }
+            defined_in.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    SymbolId entry = globals.find(options.entry);
+    if (entry == NO_SYMBOL || globals[entry].type != Symbol::Type::TEXT) {
+        throw std::runtime_error("Undefined entry point '" + options.entry + "' (it must be declared .global).");
+    }
+
+    // 3. With --gc, find what the entry point and the --keep symbols reach.
+    GcResult gc;
+    if (options.gc) {
+        std::vector<SymbolId> roots{entry};
+        for (const std::string &name : options.keep) {
+            SymbolId id = globals.find(name);
+            if (id == NO_SYMBOL) {
+                throw std::runtime_error("Undefined symbol '" + name + "' given to --keep (it must be declared .global).");
+            }
+            roots.push_back(id);
+        }
+        gc = collect_garbage(objects, globals, defined_in, roots, pool);
+    }
+
+    // 4. Lay out sections.
+    std::vector<uint32_t> code_offsets(objects.size()), data_offsets(objects.size());
+    uint64_t total_code = 0, total_data = 0;
+    for (size_t i = 0; i < objects.size(); i++) {
+        code_offsets[i] = static_cast<uint32_t>(total_code);
+        data_offsets[i] = static_cast<uint32_t>(total_data);
+        total_code += options.gc ? gc.objects[i].code_size : objects[i].code_size;
+        total_data += options.gc ? gc.objects[i].data_size : objects[i].data_size;
+    }
+    if (STAK_HEADER_SIZE + total_code + total_data > UINT32_MAX) {
+        throw std::runtime_error("Linked program exceeds 4 GiB.");
+    }
+    for (SymbolId id = 0; id < globals.size(); id++) {
+        Symbol &sym = globals[id];
+        size_t i = defined_in[id];
+        uint32_t address = sym.address;
+        if (options.gc) {
+            const GcObjectLayout &layout = gc.objects[i];
+            address = sym.type == Symbol::Type::TEXT ? layout.code_target(address) : layout.data_offset(address);
+            if (address == GC_REMOVED) {
+                continue; // Dropped: only dropped code refers to it.
+            }
+        }
+        sym.address = sym.type == Symbol::Type::TEXT ? code_offsets[i] + address
+                                                     : static_cast<uint32_t>(total_code) + data_offsets[i] + address;
+    }
+
+    // 5. Copy and relocate every object directly into the mapped output, in parallel.
+    // A --pic image is assembled in memory first and converted to records below.
+    size_t image_size = STAK_HEADER_SIZE + total_code + total_data;
+    MappedFile out;
+    std::vector<uint8_t> staging;
+    uint8_t *image;
+    if (options.pic) {
+        staging.resize(image_size);
+        image = staging.data();
+    } else {
+        out = MappedFile::create(output, image_size);
+        image = out.mutable_data();
+    }
+    uint8_t *final_code = image + STAK_HEADER_SIZE;
+    uint8_t *final_data = final_code + total_code;
+    write_header(image, globals[entry].address, static_cast<uint32_t>(total_code), static_cast<uint32_t>(total_data));
+
+    std::vector<std::vector<SymbolId>> targets(objects.size());
+    std::vector<size_t> sites_written(objects.size(), 0);
+    pool.parallel_for(objects.size(), [&](size_t i) {
+        const ParsedObjectFile &obj = objects[i];
+        uint8_t *code = final_code + code_offsets[i];
+        if (options.gc) {
+            place_object_gc(obj, gc.objects[i], code, final_data + data_offsets[i], code_offsets[i]);
+        } else {
+            place_object(obj, code, final_data + data_offsets[i], code_offsets[i]);
+        }
+        targets[i] = resolve_targets(obj, globals);
+        for (const auto &reloc : obj.relocation_table) {
+            uint32_t site = options.gc ? gc.objects[i].code_offset(reloc.offset) : reloc.offset;
+            if (site == GC_REMOVED) {
+                continue;
+            }
+            SymbolId target = targets[i][reloc.symbol];
+            if (target == NO_SYMBOL) {
+                errors[i] = undefined_symbol(obj, reloc);
+                return;
+            }
+            write_u32(code + site, globals[target].address);
+            sites_written[i]++;
+        }
+    });
+    for (const auto &error : errors) {
+        if (!error.empty()) {
+            out.close();
+            std::remove(output.c_str());
+            throw std::runtime_error(error);
+        }
+    }
+    out.close();
+    uint32_t pic_records = 0;
+    if (options.pic) {
+        DecodedCode decoded = decode_code(final_code, static_cast<uint32_t>(total_code), globals[entry].address, output);
+        write_pic_image(output, decoded, final_data, static_cast<uint32_t>(total_data));
+        pic_records = static_cast<uint32_t>(decoded.code.size());
+    }
+
+    LinkResult result;
+    result.objects = objects.size();
+    result.entry_point = globals[entry].address;
+    result.code_size = static_cast<uint32_t>(total_code);
+    result.data_size = static_cast<uint32_t>(total_data);
+    for (size_t written : sites_written) result.relocations += written;
+    result.gc = options.gc;
+    result.removed = std::move(gc.report);
+    result.pic = options.pic;
+    result.pic_records = pic_records;
+    result.archives = archives.size();
+    result.archive_members = archive_members;
+    result.members_loaded = members_loaded;
+    if (options.symbols) {
+        write_symbol_file(symbols_path_for(output), objects, code_offsets, data_offsets,
+                          static_cast<uint32_t>(total_code), options.gc ? &gc : nullptr);
+    }
+
+    // 6. Record the layout for the next incremental link. Links that pull from
+    // archives have no map: which members are needed can change with any input.
+    std::string map_path = map_path_for(output);
+    if (!options.incremental || !archives.empty()) {
+        std::remove(map_path.c_str()); // Any old map no longer describes this output.
+        return result;
+    }
+    LinkMap map;
+    map.entry = options.entry;
+    map.entry_global = entry;
+    map.code_size = result.code_size;
+    map.data_size = result.data_size;
+    map.objects.resize(objects.size());
+    pool.parallel_for(objects.size(), [&](size_t i) {
+        LinkMap::Object &record = map.objects[i];
+        record.path = objects[i].path;
+        FileStamp::of(record.path, record.stamp);
+        record.hash = hash_object(objects[i]);
+        record.code_offset = code_offsets[i];
+        record.code_size = objects[i].code_size;
+        record.data_offset = data_offsets[i];
+        record.data_size = objects[i].data_size;
+    });
+    for (SymbolId id = 0; id < globals.size(); id++) {
+        map.globals.push_back({std::string(globals.name(id)), globals[id].type, globals[id].address, defined_in[id]});
+    }
+    for (size_t i = 0; i < objects.size(); i++) {
+        for (const auto &reloc : objects[i].relocation_table) {
+            map.sites.push_back({code_offsets[i] + reloc.offset, targets[i][reloc.symbol], static_cast<uint32_t>(i)});
+        }
+    }
+    if (!FileStamp::of(output, map.output)) {
+        throw std::runtime_error("Cannot stat output file: " + output);
+    }
+    map.write(map_path);
+    return result;
+}
+
+// Patches the previous output in place when only object contents changed.
+// Returns false (with `reason` set) when a full link is required instead.
+static bool incremental_link(const std::vector<std::string> &inputs, const std::string &output,
+                             const LinkOptions &options, ThreadPool &pool, LinkResult &result,
+                             std::string &reason) {
+    std::string map_path = map_path_for(output);
+    LinkMap map;
+    if (!LinkMap::read(map_path, map)) {
+        reason = "no usable link map";
+        return false;
+    }
+    if (map.entry != options.entry || map.objects.size() != inputs.size()) {
+        reason = "input list changed";
+        return false;
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (map.objects[i].path != inputs[i]) {
+            reason = "input list changed";
+            return false;
+        }
+    }
+    FileStamp output_stamp;
+    if (!FileStamp::of(output, output_stamp) || !(output_stamp == map.output)) {
+        reason = "output was modified since the last link";
+        return false;
+    }
+
+    // 1. Find changed objects: a matching stat is trusted, otherwise compare content hashes.
+    std::vector<ParsedObjectFile> loaded(inputs.size());
+    std::vector<char> changed(inputs.size(), 0);
+    std::vector<std::string> errors(inputs.size());
+    pool.parallel_for(inputs.size(), [&](size_t i) {
+        FileStamp stamp;
+        if (FileStamp::of(inputs[i], stamp) && stamp == map.objects[i].stamp) {
+            return;
+        }
+        try {
+            loaded[i] = ParsedObjectFile::from_file(inputs[i]);
+            if (hash_object(loaded[i]) != map.objects[i].hash) {
+                changed[i] = 1;
+            }
+            map.objects[i].stamp = stamp;
+        } catch (const std::exception &e) {
+            errors[i] = e.what();
+        }
+    });
+    for (const auto &error : errors) {
+        if (!error.empty()) throw std::runtime_error(error);
+    }
+
+    // 2. Changed objects must keep their footprint and their set of exported names.
+    SymbolTable global_index;
+    for (const auto &global : map.globals) {
+        global_index.add(global.name, global.type, global.address);
+    }
+    std::vector<size_t> changed_objects;
+    std::vector<std::vector<SymbolId>> targets(inputs.size());
+    std::vector<char> moved(map.globals.size(), 0);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (!changed[i]) continue;
+        const ParsedObjectFile &obj = loaded[i];
+        const LinkMap::Object &record = map.objects[i];
+        if (obj.code_size != record.code_size || obj.data_size != record.data_size) {
+            reason = "size of " + obj.path + " changed";
+            return false;
+        }
+        size_t exported = 0;
+        for (const auto &sym : obj.symbol_table) {
+            if (sym.binding != Symbol::Binding::GLOBAL || sym.type == Symbol::Type::EXTERN) continue;
+            SymbolId id = global_index.find(sym.name);
+            if (id == NO_SYMBOL || map.globals[id].object != i || map.globals[id].type != sym.type) {
+                reason = "global symbols of " + obj.path + " changed";
+                return false;
+            }
+            uint32_t address = sym.type == Symbol::Type::TEXT
+                                   ? record.code_offset + sym.address
+                                   : map.code_size + record.data_offset + sym.address;
+            if (address != map.globals[id].address) {
+                map.globals[id].address = address;
+                moved[id] = 1;
+            }
+            exported++;
+        }
+        size_t previously_exported = 0;
+        for (const auto &global : map.globals) {
+            if (global.object == i) previously_exported++;
+        }
+        if (exported != previously_exported) {
+            reason = "global symbols of " + obj.path + " changed";
+            return false;
+        }
+        targets[i] = resolve_targets(obj, global_index);
+        for (const auto &reloc : obj.relocation_table) {
+            if (targets[i][reloc.symbol] == NO_SYMBOL) {
+                throw std::runtime_error(undefined_symbol(obj, reloc));
+            }
+        }
+        changed_objects.push_back(i);
+    }
+
+    // 3. Rewrite the changed objects and every relocation site that points at a moved symbol.
+    result = LinkResult();
+    result.incremental = true;
+    result.objects = inputs.size();
+    result.code_size = map.code_size;
+    result.data_size = map.data_size;
+    result.entry_point = map.globals[map.entry_global].address;
+    if (!changed_objects.empty()) {
+        MappedFile out = MappedFile::open_write(output);
+        if (out.size() != STAK_HEADER_SIZE + static_cast<uint64_t>(map.code_size) + map.data_size) {
+            reason = "output size does not match the link map";
+            return false;
+        }
+        uint8_t *final_code = out.mutable_data() + STAK_HEADER_SIZE;
+        uint8_t *final_data = final_code + map.code_size;
+
+        std::vector<std::vector<LinkMap::Site>> new_sites(changed_objects.size());
+        pool.parallel_for(changed_objects.size(), [&](size_t k) {
+            size_t i = changed_objects[k];
+            const ParsedObjectFile &obj = loaded[i];
+            const LinkMap::Object &record = map.objects[i];
+            uint8_t *code = final_code + record.code_offset;
+            place_object(obj, code, final_data + record.data_offset, record.code_offset);
+            for (const auto &reloc : obj.relocation_table) {
+                SymbolId target = targets[i][reloc.symbol];
+                write_u32(code + reloc.offset, map.globals[target].address);
+                new_sites[k].push_back({record.code_offset + reloc.offset, target, static_cast<uint32_t>(i)});
+            }
+            map.objects[i].hash = hash_object(obj);
+        });
+
+        // Sites inside changed objects were just rewritten; patch the rest if their target moved.
+        std::vector<LinkMap::Site> sites;
+        sites.reserve(map.sites.size());
+        for (const auto &site : map.sites) {
+            if (changed[site.object]) continue;
+            if (moved[site.global]) {
+                write_u32(final_code + site.code_offset, map.globals[site.global].address);
+                result.relocations++;
+            }
+            sites.push_back(site);
+        }
+        for (auto &group : new_sites) {
+            result.relocations += group.size();
+            sites.insert(sites.end(), group.begin(), group.end());
+        }
+        map.sites = std::move(sites);
+
+        result.entry_point = map.globals[map.entry_global].address;
+        write_u32(out.mutable_data() + 4, result.entry_point);
+        out.close();
+        result.objects_relinked = changed_objects.size();
+    }
+
+    if (!FileStamp::of(output, map.output)) {
+        throw std::runtime_error("Cannot stat output file: " + output);
+    }
+    map.write(map_path);
+    return true;
+}
+
+LinkResult link_objects(const std::vector<std::string> &inputs, const std::string &output,
+                        const LinkOptions &options) {
+    if (inputs.empty()) {
+        throw std::runtime_error("No input files.");
+    }
+    if (options.gc && options.incremental) {
+        throw std::runtime_error("--gc cannot be combined with --incremental.");
+    }
+    if (options.pic && options.incremental) {
+        throw std::runtime_error("--pic cannot be combined with --incremental.");
+    }
+    if (!options.symbols) {
+        std::remove(symbols_path_for(output).c_str()); // It would name the old layout.
+    }
+    ThreadPool pool(options.jobs);
+
+    LinkResult result;
+    if (options.incremental) {
+        std::string reason = "--symbols lists every address";
+        if (!options.symbols && incremental_link(inputs, output, options, pool, result, reason)) {
+            return result;
+        }
+        result = full_link(inputs, output, options, pool);
+        result.fallback_reason = reason;
+        return result;
+    }
+    return full_link(inputs, output, options, pool);
+}
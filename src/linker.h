@@ -0,0 +1,90 @@
+// File: linker.h
+// Owner: Rashmitha
+// Role: Linker Core Logic
+// Description: Combines relocatable STAO object files (.o) into one STAK executable (.vm),
+//              following Linker_design.md.
+
+#ifndef LINKER_H
+#define LINKER_H
+
+#include "link_gc.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr uint32_t STAK_MAGIC = 0x5354414B; // "STAK"
+constexpr uint32_t STAK_HEADER_SIZE = 16;
+
+struct LinkOptions
+{
+    unsigned jobs = 0;          // Worker threads for loading and relocation (0 = one per core).
+    std::string entry = "main"; // Global symbol whose address goes in the header.
+    bool incremental = false;   // Keep <output>.map and patch only changed objects next time.
+    bool gc = false;            // Drop code and data the entry point cannot reach (--gc).
+    std::vector<std::string> keep; // Extra --gc roots, e.g. data read by name.
+    bool symbols = false;       // Also write <output>.sym for profilers (--symbols).
+    bool pic = false;           // Write a position-independent image (--pic, see stak_image.h).
+};
+
+struct LinkResult
+{
+    size_t objects = 0;
+    uint32_t entry_point = 0;
+    uint32_t code_size = 0;
+    uint32_t data_size = 0;
+    size_t relocations = 0;       // Relocation sites written.
+
+    // Incremental links only.
+    bool incremental = false;     // True if the previous output was patched in place.
+    size_t objects_relinked = 0;  // Objects whose bytes were rewritten.
+    std::string fallback_reason;  // Why a full link was done instead, if one was.
+
+    // Archive inputs: members are only parsed when they resolve a needed symbol.
+    size_t archives = 0;
+    size_t archive_members = 0;   // In all archives.
+    size_t members_loaded = 0;    // Pulled in; counted in `objects`.
+
+    // --gc only.
+    bool gc = false;
+    GcReport removed;             // What was dropped; code_size and data_size are after removal.
+
+    // --pic only.
+    bool pic = false;
+    uint32_t pic_records = 0;     // Instruction records, including the end-of-code sentinel.
+};
+
+// Links `inputs` into the executable `output`. Throws std::runtime_error on
+// undefined or duplicate global symbols and malformed inputs.
+//
+// With options.incremental, a link map is written to <output>.map. A later
+// incremental link with the same input list rewrites only the objects whose
+// contents changed, plus the relocation sites of globals that moved. It falls
+// back to a full link if an object's size or its exported symbols change.
+//
+// With options.gc, only the functions and data entries reachable from the
+// entry point and the options.keep symbols are written, packed in input
+// order; references from dropped code need not resolve. It cannot be combined
+// with options.incremental.
+//
+// An input may also be a STAR archive (see archive.h). Only the members that
+// define a symbol the link needs are loaded, found through the archive's
+// index; they are placed after the object files. Links that use archives are
+// always full links.
+//
+// With options.symbols, every code and data symbol of every object, locals
+// included, is written to <output>.sym at its final address, one
+// "<hex address> <type> <name>" line each as nm prints them: T/t for global or
+// local code, D/d for data. The VM's profiler names functions with it. This
+// needs a full link; without the option any old <output>.sym is removed.
+//
+// With options.pic, the output is a position-independent image instead of a
+// classic STAK file: the same code, decoded to fixed-size records whose
+// branches are instruction indices, with code and data in separate
+// page-aligned segments the VM maps and runs without copying or fixups.
+// Addresses in <output>.sym and in reports stay classic byte offsets. It
+// cannot be combined with options.incremental.
+LinkResult link_objects(const std::vector<std::string> &inputs, const std::string &output,
+                        const LinkOptions &options = {});
+
+#endif // LINKER_H
@@ -0,0 +1,122 @@
+// File: mapped_file.cpp
+// Owner: Team
+// Role: File I/O Support
+// Description: Implementation of the mmap wrappers.
+
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::runtime_error io_error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept : bytes(other.bytes), length(other.length) {
+    other.bytes = nullptr;
+    other.length = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        bytes = other.bytes;
+        length = other.length;
+        other.bytes = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+void MappedFile::close() {
+    if (bytes) {
+        munmap(bytes, length);
+    }
+    bytes = nullptr;
+    length = 0;
+}
+
+MappedFile MappedFile::open_read(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw io_error("Cannot open file", path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw io_error("Cannot stat file", path);
+    }
+    MappedFile file;
+    file.length = static_cast<size_t>(st.st_size);
+    if (file.length > 0) {
+        void *p = mmap(nullptr, file.length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw io_error("Cannot map file", path);
+        }
+        file.bytes = static_cast<uint8_t *>(p);
+    }
+    ::close(fd);
+    return file;
+}
+
+MappedFile MappedFile::create(const std::string &path, size_t size) {
+    // Replace an existing regular file rather than rewriting it, so a file that is
+    // still mapped or hardlinked elsewhere is never modified.
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+        ::unlink(path.c_str());
+    }
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw io_error("Cannot create file", path);
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        throw io_error("Cannot size file", path);
+    }
+    MappedFile file;
+    file.length = size;
+    if (size > 0) {
+        void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw io_error("Cannot map file", path);
+        }
+        file.bytes = static_cast<uint8_t *>(p);
+    }
+    ::close(fd);
+    return file;
+}
+
+MappedFile MappedFile::open_write(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        throw io_error("Cannot open file", path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw io_error("Cannot stat file", path);
+    }
+    MappedFile file;
+    file.length = static_cast<size_t>(st.st_size);
+    if (file.length > 0) {
+        void *p = mmap(nullptr, file.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw io_error("Cannot map file", path);
+        }
+        file.bytes = static_cast<uint8_t *>(p);
+    }
+    ::close(fd);
+    return file;
+}
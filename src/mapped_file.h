@@ -0,0 +1,45 @@
+// File: mapped_file.h
+// Owner: Team
+// Role: File I/O Support
+// Description: RAII wrappers around mmap for reading inputs in place and for
+//              writing presized outputs without intermediate buffers.
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Maps an existing file read-only. Throws std::runtime_error on failure.
+    static MappedFile open_read(const std::string &path);
+
+    // Creates (or truncates) `path` with exactly `size` bytes and maps it
+    // writable and shared, so stores land directly in the file.
+    static MappedFile create(const std::string &path, size_t size);
+
+    // Maps an existing file writable and shared, for patching it in place.
+    static MappedFile open_write(const std::string &path);
+
+    const uint8_t *data() const { return bytes; }
+    uint8_t *mutable_data() { return bytes; }
+    size_t size() const { return length; }
+
+    // Unmaps early; also done by the destructor.
+    void close();
+
+private:
+    uint8_t *bytes = nullptr;
+    size_t length = 0;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,249 @@
+// File: object_file.cpp
+// Owner: Rashmitha
+// Role: Linker Data Structures
+// Description: Parses mapped STAO object files (v4, and v3/v2/v1 for older objects) into
+//              section and table views.
+
+#include "object_file.h"
+#include "byte_io.h"
+#include "opcodes.h"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+ParsedObjectFile ParsedObjectFile::from_file(const std::string &filepath) {
+    auto file = std::make_shared<const MappedFile>(MappedFile::open_read(filepath));
+    size_t size = file->size();
+    return from_mapping(std::move(file), 0, size, filepath);
+}
+
+ParsedObjectFile ParsedObjectFile::from_mapping(std::shared_ptr<const MappedFile> file, size_t start, size_t size,
+                                                const std::string &filepath) {
+    ParsedObjectFile obj;
+    obj.path = filepath;
+    obj.mapping = std::move(file);
+    obj.bytes = obj.mapping->data() + start;
+    obj.length = size;
+
+    ByteReader header(obj.bytes, obj.length, obj.path);
+    uint32_t magic = header.u32();
+    if (magic == STAO2_MAGIC) {
+        obj.read_v2();
+    } else if (magic == STAO_MAGIC) {
+        obj.read_v1();
+    } else {
+        throw std::runtime_error("Not a STAO object file: " + filepath);
+    }
+
+    for (const auto &reloc : obj.relocation_table) {
+        if (static_cast<uint64_t>(reloc.offset) + 4 > obj.code_size) {
+            throw std::runtime_error("Relocation outside the code section: " + filepath);
+        }
+    }
+    // The emitter writes relocations in code order; only foreign files need sorting.
+    auto by_offset = [](const ObjectRelocation &a, const ObjectRelocation &b) { return a.offset < b.offset; };
+    if (!std::is_sorted(obj.relocation_table.begin(), obj.relocation_table.end(), by_offset)) {
+        std::sort(obj.relocation_table.begin(), obj.relocation_table.end(), by_offset);
+    }
+
+    // Decode the code stream once: find the operands of local branches, i.e.
+    // long-form branches that are not relocation sites. With the relocations
+    // sorted by offset, one merge-walk suffices; it also rejects relocations
+    // that are not the operand of a long-form branch, which the linker would
+    // otherwise patch into the middle of an instruction. Instruction boundaries
+    // are marked so branch targets can be checked.
+    bool by_instruction = obj.instruction_addressed();
+    std::vector<uint8_t> boundary(static_cast<size_t>(obj.code_size) + 1, 0);
+    std::vector<std::pair<uint32_t, int64_t>> relative; // Branch offset, target.
+    size_t next_reloc = 0;
+    auto reject_reloc = [&](const ObjectRelocation &reloc) {
+        throw std::runtime_error("Relocation at code offset " + std::to_string(reloc.offset) +
+                                 " is not a branch operand: " + filepath);
+    };
+    uint32_t offset = 0;
+    while (offset < obj.code_size) {
+        Opcode op = static_cast<Opcode>(obj.code[offset]);
+        uint32_t size = encoded_size(op);
+        if (size == 0 || offset + size > obj.code_size || (by_instruction && long_form(op) != op)) {
+            throw std::runtime_error("Invalid instruction at code offset " + std::to_string(offset) + " in " + filepath);
+        }
+        boundary[offset] = 1;
+        if (by_instruction) {
+            obj.instruction_offsets.push_back(offset);
+        }
+        if (next_reloc < obj.relocation_table.size() && obj.relocation_table[next_reloc].offset < offset + size &&
+            !(is_branch(op) && obj.relocation_table[next_reloc].offset == offset + 1)) {
+            reject_reloc(obj.relocation_table[next_reloc]);
+        }
+        if (is_branch(op)) {
+            bool relocated = next_reloc < obj.relocation_table.size() &&
+                             obj.relocation_table[next_reloc].offset == offset + 1;
+            if (relocated) {
+                next_reloc++;
+            } else {
+                obj.local_branch_sites.push_back(offset + 1);
+            }
+        } else if (is_relative_branch(op)) {
+            relative.push_back({offset, static_cast<int64_t>(offset) + size + decode_instruction(obj.code + offset).operand});
+        }
+        offset += size;
+    }
+    boundary[obj.code_size] = 1;
+    if (next_reloc < obj.relocation_table.size()) {
+        reject_reloc(obj.relocation_table[next_reloc]);
+    }
+    if (by_instruction) {
+        obj.instruction_offsets.push_back(obj.code_size);
+        for (auto &sym : obj.symbol_table) {
+            if (sym.type == Symbol::Type::TEXT) {
+                if (sym.address >= obj.instruction_offsets.size()) {
+                    throw std::runtime_error("Symbol '" + std::string(sym.name) + "' outside the code section: " + filepath);
+                }
+                sym.address = obj.instruction_offsets[sym.address];
+            }
+        }
+    }
+    auto check_target = [&](uint32_t at, int64_t target) {
+        if (target < 0 || target > obj.code_size || !boundary[target]) {
+            throw std::runtime_error("Branch at code offset " + std::to_string(at) + " in " + filepath +
+                                     " does not target an instruction");
+        }
+    };
+    for (uint32_t site : obj.local_branch_sites) {
+        bool in_range = !by_instruction || read_u32(obj.code + site) < obj.instruction_offsets.size();
+        check_target(site - 1, in_range ? static_cast<int64_t>(obj.local_target(site)) : -1);
+    }
+    for (const auto &branch : relative) {
+        check_target(branch.first, branch.second);
+    }
+    return obj;
+}
+
+void ParsedObjectFile::copy_data(uint32_t begin, uint32_t end, uint8_t *out) const {
+    uint32_t stored_end = std::min(end, stored_data_size);
+    if (begin < stored_end) {
+        out = std::copy(data + begin, data + stored_end, out);
+        begin = stored_end;
+    }
+    std::fill(out, out + (end - begin), uint8_t(0));
+}
+
+uint32_t ParsedObjectFile::local_target(uint32_t site) const {
+    uint32_t operand = read_u32(code + site);
+    return instruction_addressed() ? instruction_offsets[operand] : operand;
+}
+
+// Fixed-size records, located through the header: each one is read where it lies.
+void ParsedObjectFile::read_v2() {
+    const uint8_t *file = bytes;
+    uint64_t file_size = length;
+    if (file_size < STAO2_V3_HEADER_SIZE) {
+        throw std::runtime_error("Truncated file: " + path);
+    }
+    version = read_u32(file + stao2::VERSION);
+    if (version != STAO2_VERSION && version != STAO2_BYTE_ADDRESSED_VERSION &&
+        version != STAO2_INSTRUCTION_ADDRESSED_VERSION) {
+        throw std::runtime_error("Unsupported STAO version " + std::to_string(read_u32(file + stao2::VERSION)) +
+                                 ": " + path);
+    }
+    uint32_t zero_size = 0;
+    if (version == STAO2_VERSION) {
+        if (file_size < STAO2_HEADER_SIZE) {
+            throw std::runtime_error("Truncated file: " + path);
+        }
+        zero_size = read_u32(file + stao2::ZERO_SIZE);
+    }
+    auto section = [&](uint32_t offset_field, uint64_t size) {
+        uint32_t offset = read_u32(file + offset_field);
+        if (offset % 4 != 0 || offset + size > file_size) {
+            throw std::runtime_error("Section outside the file: " + path);
+        }
+        return file + offset;
+    };
+
+    code_size = read_u32(file + stao2::CODE_SIZE);
+    code = section(stao2::CODE_OFFSET, code_size);
+    stored_data_size = read_u32(file + stao2::DATA_SIZE);
+    data = section(stao2::DATA_OFFSET, stored_data_size);
+    if (static_cast<uint64_t>(stored_data_size) + zero_size > UINT32_MAX) {
+        throw std::runtime_error("Data section exceeds 4 GiB: " + path);
+    }
+    data_size = stored_data_size + zero_size;
+    uint32_t strings_size = read_u32(file + stao2::STRINGS_SIZE);
+    const char *strings = reinterpret_cast<const char *>(section(stao2::STRINGS_OFFSET, strings_size));
+
+    uint32_t symbol_count = read_u32(file + stao2::SYMBOL_COUNT);
+    const uint8_t *record = section(stao2::SYMBOLS_OFFSET, static_cast<uint64_t>(symbol_count) * STAO2_SYMBOL_SIZE);
+    symbol_table.resize(symbol_count);
+    for (ObjectFileSymbol &sym : symbol_table) {
+        uint32_t name_offset = read_u32(record);
+        uint32_t name_length = read_u32(record + 4);
+        uint8_t type = record[12];
+        uint8_t binding = record[13];
+        if (static_cast<uint64_t>(name_offset) + name_length > strings_size ||
+            type > static_cast<uint8_t>(Symbol::Type::EXTERN) || binding > static_cast<uint8_t>(Symbol::Binding::GLOBAL)) {
+            throw std::runtime_error("Invalid symbol record in " + path);
+        }
+        sym.name = std::string_view(strings + name_offset, name_length);
+        sym.address = read_u32(record + 8);
+        sym.type = static_cast<Symbol::Type>(type);
+        sym.binding = static_cast<Symbol::Binding>(binding);
+        record += STAO2_SYMBOL_SIZE;
+    }
+
+    uint32_t reloc_count = read_u32(file + stao2::RELOC_COUNT);
+    record = section(stao2::RELOCS_OFFSET, static_cast<uint64_t>(reloc_count) * STAO2_RELOC_SIZE);
+    relocation_table.resize(reloc_count);
+    for (ObjectRelocation &reloc : relocation_table) {
+        reloc.offset = read_u32(record);
+        reloc.symbol = read_u32(record + 4);
+        if (reloc.symbol >= symbol_count) {
+            throw std::runtime_error("Relocation against a missing symbol in " + path);
+        }
+        record += STAO2_RELOC_SIZE;
+    }
+}
+
+// Variable-length records, read in sequence. Relocations name their target,
+// so names are matched to symbol indices here.
+void ParsedObjectFile::read_v1() {
+    ByteReader header(bytes + 4, length - 4, path);
+    code_size = header.u32();
+    data_size = header.u32();
+    uint32_t symbol_table_size = header.u32();
+    uint32_t reloc_table_size = header.u32();
+    code = header.bytes(code_size);
+    data = header.bytes(data_size);
+    stored_data_size = data_size;
+
+    ByteReader symbols(header.bytes(symbol_table_size), symbol_table_size, path);
+    uint32_t symbol_count = symbols.u32();
+    symbol_table.reserve(symbol_count);
+    std::unordered_map<std::string_view, uint32_t> index;
+    for (uint32_t i = 0; i < symbol_count; i++) {
+        ObjectFileSymbol sym;
+        sym.name = symbols.string();
+        sym.type = static_cast<Symbol::Type>(symbols.u8());
+        sym.binding = static_cast<Symbol::Binding>(symbols.u8());
+        sym.address = symbols.u32();
+        index.emplace(sym.name, i);
+        symbol_table.push_back(sym);
+    }
+
+    ByteReader relocs(header.bytes(reloc_table_size), reloc_table_size, path);
+    uint32_t reloc_count = relocs.u32();
+    relocation_table.reserve(reloc_count);
+    for (uint32_t i = 0; i < reloc_count; i++) {
+        ObjectRelocation reloc;
+        reloc.offset = relocs.u32();
+        std::string_view target = relocs.string();
+        auto found = index.find(target);
+        if (found == index.end()) {
+            // v1 allowed targets missing from the symbol table; treat them as externs.
+            found = index.emplace(target, static_cast<uint32_t>(symbol_table.size())).first;
+            symbol_table.push_back({target, Symbol::Type::EXTERN, Symbol::Binding::GLOBAL, 0});
+        }
+        reloc.symbol = found->second;
+        relocation_table.push_back(reloc);
+    }
+}
@@ -0,0 +1,138 @@
+// File: object_file.h
+// Owner: Rashmitha
+// Role: Linker Data Structures
+// Description: Read-side view of a relocatable STAO object file (.o). The file is
+//              memory-mapped and its sections are exposed in place, without copies.
+
+#ifndef OBJECT_FILE_H
+#define OBJECT_FILE_H
+
+#include "mapped_file.h"
+#include "symbol_table.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint32_t STAO_MAGIC = 0x5354414F; // "STAO": version 1, read-only.
+
+// STAO version 2, written by the emitter. All fields are little-endian u32
+// unless noted, and every section starts on a 4-byte boundary:
+//
+//   header    STAO2_HEADER_SIZE bytes: magic, version, then offset and size (or
+//             count) of the code, data, symbol, relocation and string sections,
+//             then the zero-fill size
+//   code      raw bytecode, zero-padded to a multiple of 4; code addresses
+//             (TEXT symbols, local jmp/invoke operands) are byte offsets into it
+//   data      initialized static data, zero-padded to a multiple of 4. The
+//             section continues with zero-fill size bytes of zeros (.space)
+//             that are not stored; DATA symbols may address them.
+//   symbols   symbol_count records of STAO2_SYMBOL_SIZE bytes:
+//             name offset, name length, address, u8 type, u8 binding, u16 reserved
+//   relocs    reloc_count records of STAO2_RELOC_SIZE bytes:
+//             code offset of the operand, index of the target symbol
+//   strings   every symbol name once, back to back, without terminators
+//
+// Records have fixed sizes, so any symbol or relocation can be read in place
+// from the mapped file without parsing the ones before it.
+//
+// Version 4 added the zero-fill size. Version 3 added the short encodings and
+// byte-offset code addresses; its header ends before the zero-fill size.
+// Version 2 files have the v3 layout, but their code addresses count instructions.
+constexpr uint32_t STAO2_MAGIC = 0x53544F32; // "STO2"
+constexpr uint32_t STAO2_VERSION = 4;
+constexpr uint32_t STAO2_BYTE_ADDRESSED_VERSION = 3;
+constexpr uint32_t STAO2_INSTRUCTION_ADDRESSED_VERSION = 2;
+constexpr uint32_t STAO2_HEADER_SIZE = 52;
+constexpr uint32_t STAO2_V3_HEADER_SIZE = 48;
+constexpr uint32_t STAO2_SYMBOL_SIZE = 16;
+constexpr uint32_t STAO2_RELOC_SIZE = 8;
+
+// Byte offsets of the v2 header fields.
+namespace stao2 {
+constexpr uint32_t VERSION = 4;
+constexpr uint32_t CODE_OFFSET = 8;
+constexpr uint32_t CODE_SIZE = 12;
+constexpr uint32_t DATA_OFFSET = 16;
+constexpr uint32_t DATA_SIZE = 20;
+constexpr uint32_t SYMBOLS_OFFSET = 24;
+constexpr uint32_t SYMBOL_COUNT = 28;
+constexpr uint32_t RELOCS_OFFSET = 32;
+constexpr uint32_t RELOC_COUNT = 36;
+constexpr uint32_t STRINGS_OFFSET = 40;
+constexpr uint32_t STRINGS_SIZE = 44;
+constexpr uint32_t ZERO_SIZE = 48;
+} // namespace stao2
+
+// Rounds a section size up to the next 4-byte boundary.
+constexpr uint32_t stao2_align(uint32_t size) { return (size + 3) & ~3u; }
+
+// A symbol as defined in the .o file's symbol table. The name points into the mapping.
+struct ObjectFileSymbol {
+    std::string_view name;
+    Symbol::Type type;
+    Symbol::Binding binding;
+    uint32_t address; // Byte offset from the start of its section in the .o file.
+};
+
+// A relocation entry from the .o file.
+struct ObjectRelocation {
+    uint32_t offset; // Offset within the code section of THIS file to patch.
+    uint32_t symbol; // Index of the target in the object's symbol_table.
+};
+
+// A complete in-memory view of a single parsed .o file.
+class ParsedObjectFile {
+public:
+    std::string path;
+    const uint8_t *code = nullptr;
+    uint32_t code_size = 0;
+    const uint8_t *data = nullptr;
+    uint32_t data_size = 0;        // Including the zero fill.
+    uint32_t stored_data_size = 0; // The bytes `data` points to; the rest are zeros.
+    std::vector<ObjectFileSymbol> symbol_table;
+    std::vector<ObjectRelocation> relocation_table;
+
+    // Found by decoding the code section: the operand offsets of local long-form
+    // jmp/invoke instructions, which hold absolute code addresses the linker must
+    // rebase. Short branches are relative and need no patching.
+    std::vector<uint32_t> local_branch_sites;
+
+    // Writes data bytes [begin, end) to `out`, zeros included.
+    void copy_data(uint32_t begin, uint32_t end, uint8_t *out) const;
+
+    // The byte offset within this object's code that the local branch operand at
+    // `site` targets. Checked at load to be an instruction boundary (or the end).
+    uint32_t local_target(uint32_t site) const;
+
+    // Maps and parses a v4, v3, v2 or v1 object file, validating the magic number,
+    // section bounds, symbol references and code stream. Throws
+    // std::runtime_error on failure.
+    static ParsedObjectFile from_file(const std::string &filepath);
+
+    // Parses the object stored at [start, start + size) of an already mapped
+    // file in place, e.g. an archive member; `filepath` names it, as in "lib.a(math.o)".
+    static ParsedObjectFile from_mapping(std::shared_ptr<const MappedFile> file, size_t start, size_t size,
+                                         const std::string &filepath);
+
+    // The object's bytes, e.g. for content hashing.
+    const uint8_t *file_data() const { return bytes; }
+    size_t file_size() const { return length; }
+
+private:
+    void read_v1();
+    void read_v2();
+
+    bool instruction_addressed() const { return version < STAO2_BYTE_ADDRESSED_VERSION; }
+
+    std::shared_ptr<const MappedFile> mapping; // Shared by every member of one archive.
+    const uint8_t *bytes = nullptr;
+    size_t length = 0;
+    uint32_t version = 1;
+    // v1 and v2 only: byte offset of every instruction, then code_size. Their
+    // code addresses are instruction indices and are translated through this.
+    std::vector<uint32_t> instruction_offsets;
+};
+
+#endif // OBJECT_FILE_H
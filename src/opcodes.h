@@ -0,0 +1,197 @@
+// File: opcodes.h
+// Owner: CS22B015 Kowshik
+// Role: Bytecode & Back-end
+// Description: Opcode numbering and encoded instruction sizes shared by the
+//              assembler, linker and virtual machine.
+
+#ifndef OPCODES_H
+#define OPCODES_H
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- Opcodes ---
+enum class Opcode : uint8_t {
+    ICONST = 0x01,
+    IADD   = 0x02,
+    ISUB   = 0x03,
+    IMUL   = 0x04,
+    IDIV   = 0x05,
+    RET    = 0x06,
+    JMP    = 0x07,
+    INVOKE = 0x08,
+
+    // Superinstructions produced by the optimizer: `iconst k` fused with the
+    // arithmetic instruction that follows it; the operand is k.
+    ICONST_IADD = 0x09,
+    ICONST_ISUB = 0x0A,
+    ICONST_IMUL = 0x0B,
+    ICONST_IDIV = 0x0C,
+
+    // Short forms chosen by the emitter's layout pass. ICONST8/16 carry a
+    // sign-extended constant; the branch forms carry a signed byte displacement
+    // from the end of the branch instruction to its target.
+    ICONST8  = 0x0D,
+    ICONST16 = 0x0E,
+    JMP8     = 0x0F,
+    JMP16    = 0x10,
+    INVOKE8  = 0x11,
+    INVOKE16 = 0x12
+};
+
+// Number of bytes an instruction occupies in the code section (opcode included).
+// Returns 0 for bytes that are not a valid opcode.
+constexpr uint32_t encoded_size(Opcode op) {
+    switch (op) {
+        case Opcode::ICONST: return 5; // opcode + int32 value
+        case Opcode::IADD:
+        case Opcode::ISUB:
+        case Opcode::IMUL:
+        case Opcode::IDIV:
+        case Opcode::RET:    return 1;
+        case Opcode::JMP:    return 5; // opcode + int32 address
+        case Opcode::INVOKE: return 6; // opcode + int32 address + uint8 num_args
+        case Opcode::ICONST_IADD:
+        case Opcode::ICONST_ISUB:
+        case Opcode::ICONST_IMUL:
+        case Opcode::ICONST_IDIV: return 5; // opcode + int32 value
+        case Opcode::ICONST8:  return 2;  // opcode + int8 value
+        case Opcode::ICONST16: return 3;  // opcode + int16 value
+        case Opcode::JMP8:     return 2;  // opcode + int8 displacement
+        case Opcode::JMP16:    return 3;  // opcode + int16 displacement
+        case Opcode::INVOKE8:  return 3;  // opcode + int8 displacement + uint8 num_args
+        case Opcode::INVOKE16: return 4;  // opcode + int16 displacement + uint8 num_args
+    }
+    return 0;
+}
+
+// Mnemonic for reports. Superinstructions are named after the pair they fuse.
+constexpr const char *opcode_name(Opcode op) {
+    switch (op) {
+        case Opcode::ICONST:      return "iconst";
+        case Opcode::IADD:        return "iadd";
+        case Opcode::ISUB:        return "isub";
+        case Opcode::IMUL:        return "imul";
+        case Opcode::IDIV:        return "idiv";
+        case Opcode::RET:         return "ret";
+        case Opcode::JMP:         return "jmp";
+        case Opcode::INVOKE:      return "invoke";
+        case Opcode::ICONST_IADD: return "iconst+iadd";
+        case Opcode::ICONST_ISUB: return "iconst+isub";
+        case Opcode::ICONST_IMUL: return "iconst+imul";
+        case Opcode::ICONST_IDIV: return "iconst+idiv";
+        case Opcode::ICONST8:     return "iconst8";
+        case Opcode::ICONST16:    return "iconst16";
+        case Opcode::JMP8:        return "jmp8";
+        case Opcode::JMP16:       return "jmp16";
+        case Opcode::INVOKE8:     return "invoke8";
+        case Opcode::INVOKE16:    return "invoke16";
+    }
+    return "invalid";
+}
+
+// True for instructions whose operand is an absolute code address (a byte
+// offset into the code section). Only these are relocated or rebased.
+constexpr bool is_branch(Opcode op) {
+    return op == Opcode::JMP || op == Opcode::INVOKE;
+}
+
+// True for the short branch forms, whose operand is relative to the next instruction.
+constexpr bool is_relative_branch(Opcode op) {
+    return op == Opcode::JMP8 || op == Opcode::JMP16 || op == Opcode::INVOKE8 || op == Opcode::INVOKE16;
+}
+
+// The long-form instruction a short form stands for; other opcodes map to themselves.
+constexpr Opcode long_form(Opcode op) {
+    switch (op) {
+        case Opcode::ICONST8:
+        case Opcode::ICONST16: return Opcode::ICONST;
+        case Opcode::JMP8:
+        case Opcode::JMP16:    return Opcode::JMP;
+        case Opcode::INVOKE8:
+        case Opcode::INVOKE16: return Opcode::INVOKE;
+        default:               return op;
+    }
+}
+
+// Operand-stack effect of the straight-line instructions: how many values
+// they pop, then how many they push. jmp, invoke and ret move control instead
+// and report {0, 0}; invoke pops its argument count and pushes whatever the
+// callee returns.
+struct StackEffect {
+    int pops;
+    int pushes;
+};
+
+constexpr StackEffect stack_effect(Opcode op) {
+    switch (op) {
+        case Opcode::ICONST: return {0, 1};
+        case Opcode::IADD:
+        case Opcode::ISUB:
+        case Opcode::IMUL:
+        case Opcode::IDIV:   return {2, 1};
+        case Opcode::ICONST_IADD:
+        case Opcode::ICONST_ISUB:
+        case Opcode::ICONST_IMUL:
+        case Opcode::ICONST_IDIV: return {1, 1};
+        default:             return {0, 0};
+    }
+}
+
+// One instruction with its operands unpacked, as the VM executes it and the
+// stack verifier analyses it.
+struct DecodedInstruction
+{
+    Opcode op;
+    uint8_t num_args;   // invoke only
+    int32_t operand;    // iconst value, or the target instruction index of jmp/invoke
+};
+
+// A read-only run of decoded instructions: a std::vector, or records mapped
+// straight from a position-independent image.
+class CodeView {
+public:
+    CodeView() = default;
+    CodeView(const DecodedInstruction *first, size_t count) : first(first), count(count) {}
+    CodeView(const std::vector<DecodedInstruction> &code) : first(code.data()), count(code.size()) {}
+
+    const DecodedInstruction *data() const { return first; }
+    size_t size() const { return count; }
+    const DecodedInstruction &operator[](size_t i) const { return first[i]; }
+
+private:
+    const DecodedInstruction *first = nullptr;
+    size_t count = 0;
+};
+
+// Decodes the instruction at `at`, which must hold encoded_size(*at) valid
+// bytes, into its long form. A branch operand is left as encoded: an absolute
+// code offset for jmp/invoke, a displacement for the short forms (check
+// is_relative_branch on the original opcode).
+inline DecodedInstruction decode_instruction(const uint8_t *at) {
+    Opcode op = static_cast<Opcode>(at[0]);
+    DecodedInstruction instr{long_form(op), 0, 0};
+    switch (encoded_size(op) - (instr.op == Opcode::INVOKE ? 1 : 0)) {
+        case 2: instr.operand = static_cast<int8_t>(at[1]); break;
+        case 3: instr.operand = static_cast<int16_t>(at[1] | (at[2] << 8)); break;
+        case 5: instr.operand = static_cast<int32_t>(at[1] | (at[2] << 8) | (at[3] << 16) |
+                                                     (static_cast<uint32_t>(at[4]) << 24)); break;
+        default: break;
+    }
+    if (instr.op == Opcode::INVOKE) {
+        instr.num_args = at[encoded_size(op) - 1];
+    }
+    return instr;
+}
+
+// --- Integer semantics ---
+// Shared by the virtual machine and the optimizer's constant folder: arithmetic
+// wraps, and INT_MIN / -1 yields INT_MIN. Division by zero is the caller's to trap.
+constexpr int32_t wrap_add(int32_t a, int32_t b) { return static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b)); }
+constexpr int32_t wrap_sub(int32_t a, int32_t b) { return static_cast<int32_t>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b)); }
+constexpr int32_t wrap_mul(int32_t a, int32_t b) { return static_cast<int32_t>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b)); }
+constexpr int32_t wrap_div(int32_t a, int32_t b) { return (a == INT_MIN && b == -1) ? INT_MIN : a / b; }
+
+#endif // OPCODES_H
@@ -0,0 +1,225 @@
+// File: optimizer.cpp
+// Owner: Team
+// Role: Peephole Optimizer
+// Description: Implementation of jump-chain collapsing, constant folding, superinstruction
+//              fusion and removal of jumps to the next instruction.
+
+#include "optimizer.h"
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+uint32_t code_bytes(const InstructionStream &instrs) {
+    uint32_t size = 0;
+    for (Opcode op : instrs.opcodes) {
+        size += encoded_size(op);
+    }
+    return size;
+}
+
+bool is_arithmetic(Opcode op) {
+    return op == Opcode::IADD || op == Opcode::ISUB || op == Opcode::IMUL || op == Opcode::IDIV;
+}
+
+Opcode fused_form(Opcode op) {
+    switch (op) {
+        case Opcode::IADD: return Opcode::ICONST_IADD;
+        case Opcode::ISUB: return Opcode::ICONST_ISUB;
+        case Opcode::IMUL: return Opcode::ICONST_IMUL;
+        default:           return Opcode::ICONST_IDIV;
+    }
+}
+
+int32_t fold(Opcode op, int32_t a, int32_t b) {
+    switch (op) {
+        case Opcode::IADD: return wrap_add(a, b);
+        case Opcode::ISUB: return wrap_sub(a, b);
+        case Opcode::IMUL: return wrap_mul(a, b);
+        default:           return wrap_div(a, b);
+    }
+}
+
+// The instruction index a branch operand lands on, or SIZE_MAX when the target
+// is not a code label of this unit (e.g. an .extern resolved by the linker).
+size_t target_index(const AssemblyUnit &unit, int32_t operand) {
+    const Symbol &sym = unit.symbol_table[static_cast<SymbolId>(operand)];
+    return sym.type == Symbol::Type::TEXT ? sym.address : SIZE_MAX;
+}
+
+// Points every branch whose target is itself a jmp at that jmp's final destination.
+// Chains are resolved once each and memoised; jmp cycles are left alone.
+size_t collapse_chains(AssemblyUnit &unit) {
+    InstructionStream &instrs = unit.instructions;
+    const size_t n = instrs.size();
+    enum : uint8_t { UNSEEN, ON_PATH, DONE };
+    std::vector<uint8_t> state(n, UNSEEN);
+    std::vector<int32_t> final_target(n);
+    std::vector<size_t> path;
+
+    auto is_jmp_at = [&](size_t index) { return index < n && instrs.opcodes[index] == Opcode::JMP; };
+    for (size_t i = 0; i < n; i++) {
+        if (instrs.opcodes[i] != Opcode::JMP || state[i] != UNSEEN) {
+            continue;
+        }
+        path.clear();
+        size_t j = i;
+        int32_t result = 0;
+        bool cycle = false;
+        for (;;) {
+            state[j] = ON_PATH;
+            path.push_back(j);
+            size_t next = target_index(unit, instrs.operands[j]);
+            if (!is_jmp_at(next)) {
+                result = instrs.operands[j];
+                break;
+            }
+            if (state[next] == DONE) {
+                result = final_target[next];
+                break;
+            }
+            if (state[next] == ON_PATH) {
+                cycle = true;
+                break;
+            }
+            j = next;
+        }
+        for (size_t p : path) {
+            final_target[p] = cycle ? instrs.operands[p] : result;
+            state[p] = DONE;
+        }
+    }
+
+    size_t collapsed = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!is_branch(instrs.opcodes[i])) {
+            continue;
+        }
+        size_t target = target_index(unit, instrs.operands[i]);
+        if (is_jmp_at(target) && final_target[target] != instrs.operands[i] &&
+            !(instrs.opcodes[i] == Opcode::JMP && final_target[i] == instrs.operands[i])) {
+            instrs.operands[i] = final_target[target];
+            collapsed++;
+        }
+    }
+    return collapsed;
+}
+
+// Replaces the instructions with `out`, where out[k] was produced from old
+// instruction origins[k], and moves every code label onto the first surviving
+// instruction that started at or after it.
+void replace_instructions(AssemblyUnit &unit, InstructionStream &out, const std::vector<uint32_t> &origins) {
+    const size_t n = unit.instructions.size();
+    std::vector<uint32_t> new_address(n + 1);
+    size_t k = 0;
+    for (size_t a = 0; a <= n; a++) {
+        while (k < origins.size() && origins[k] < a) {
+            k++;
+        }
+        new_address[a] = static_cast<uint32_t>(k);
+    }
+    for (SymbolId id = 0; id < unit.symbol_table.size(); id++) {
+        Symbol &sym = unit.symbol_table[id];
+        if (sym.type == Symbol::Type::TEXT) {
+            sym.address = new_address[sym.address];
+        }
+    }
+    unit.instructions = std::move(out);
+}
+
+// Marks the instructions a label points at.
+std::vector<bool> label_targets(const AssemblyUnit &unit) {
+    std::vector<bool> targets(unit.instructions.size() + 1, false);
+    for (const Symbol &sym : unit.symbol_table) {
+        if (sym.type == Symbol::Type::TEXT) {
+            targets[sym.address] = true;
+        }
+    }
+    return targets;
+}
+
+// One forward pass: `iconst a; iconst b; op` becomes `iconst (a op b)` and a
+// remaining `iconst k; op` becomes the ICONST_<op> superinstruction. Folding
+// repeats on its own output, so whole constant expressions collapse.
+// Division by a constant zero is never folded, so it still traps at run time.
+void fold_and_fuse(AssemblyUnit &unit, OptimizerStats &stats) {
+    const InstructionStream &instrs = unit.instructions;
+    std::vector<bool> targets = label_targets(unit);
+    InstructionStream out;
+    std::vector<uint32_t> origins;
+
+    for (size_t i = 0; i < instrs.size(); i++) {
+        Opcode op = instrs.opcodes[i];
+        size_t last = out.size() - 1;
+        if (is_arithmetic(op) && !targets[i] && !out.opcodes.empty() && out.opcodes[last] == Opcode::ICONST) {
+            int32_t rhs = out.operands[last];
+            bool can_fold = out.size() >= 2 && out.opcodes[last - 1] == Opcode::ICONST &&
+                            !targets[origins[last]] && !(op == Opcode::IDIV && rhs == 0);
+            if (can_fold) {
+                out.operands[last - 1] = fold(op, out.operands[last - 1], rhs);
+                out.opcodes.pop_back();
+                out.operands.pop_back();
+                out.arg_counts.pop_back();
+                origins.pop_back();
+                stats.constants_folded++;
+            } else {
+                out.opcodes[last] = fused_form(op);
+                stats.superinstructions++;
+            }
+            continue;
+        }
+        out.push(op, instrs.operands[i], instrs.arg_counts[i]);
+        origins.push_back(static_cast<uint32_t>(i));
+    }
+    replace_instructions(unit, out, origins);
+}
+
+// Drops every jmp that would land where execution falls through anyway: its
+// target is after it and every instruction in between is dropped too. Walking
+// backwards decides each jmp in one pass.
+void remove_jumps_to_next(AssemblyUnit &unit, OptimizerStats &stats) {
+    const InstructionStream &instrs = unit.instructions;
+    const size_t n = instrs.size();
+    std::vector<bool> removed(n, false);
+    size_t next_live = n; // First surviving instruction after i.
+    for (size_t i = n; i-- > 0;) {
+        if (instrs.opcodes[i] == Opcode::JMP) {
+            size_t target = target_index(unit, instrs.operands[i]);
+            if (target != SIZE_MAX && target > i && target <= next_live) {
+                removed[i] = true;
+                stats.jumps_removed++;
+                continue;
+            }
+        }
+        next_live = i;
+    }
+    if (stats.jumps_removed == 0) {
+        return;
+    }
+
+    InstructionStream out;
+    std::vector<uint32_t> origins;
+    for (size_t i = 0; i < n; i++) {
+        if (!removed[i]) {
+            out.push(instrs.opcodes[i], instrs.operands[i], instrs.arg_counts[i]);
+            origins.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    replace_instructions(unit, out, origins);
+}
+
+} // namespace
+
+OptimizerStats optimize(AssemblyUnit &unit) {
+    OptimizerStats stats;
+    stats.instructions_before = unit.instructions.size();
+    stats.bytes_before = code_bytes(unit.instructions);
+
+    stats.chains_collapsed = collapse_chains(unit);
+    fold_and_fuse(unit, stats);
+    remove_jumps_to_next(unit, stats);
+
+    stats.instructions_after = unit.instructions.size();
+    stats.bytes_after = code_bytes(unit.instructions);
+    return stats;
+}
@@ -0,0 +1,34 @@
+// File: optimizer.h
+// Owner: Team
+// Role: Peephole Optimizer
+// Description: Optional -O pass over a parsed AssemblyUnit, run between parsing and emission.
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "structures.h"
+#include <cstddef>
+#include <cstdint>
+
+// What one optimize() call changed.
+struct OptimizerStats
+{
+    size_t instructions_before = 0;
+    size_t instructions_after = 0;
+    uint32_t bytes_before = 0;     // Code section size.
+    uint32_t bytes_after = 0;
+    size_t constants_folded = 0;   // iconst a; iconst b; op -> iconst (a op b)
+    size_t superinstructions = 0;  // iconst k; op -> ICONST_<op> k
+    size_t jumps_removed = 0;      // jmp to the instruction that follows anyway
+    size_t chains_collapsed = 0;   // branches retargeted past an intermediate jmp
+
+    size_t instructions_removed() const { return instructions_before - instructions_after; }
+    uint32_t bytes_removed() const { return bytes_before - bytes_after; }
+};
+
+// Rewrites unit.instructions in place and moves code labels to match, so the
+// emitter's addresses and relocations stay correct. Nothing is combined across
+// a label, since control may enter there from elsewhere with any stack.
+OptimizerStats optimize(AssemblyUnit &unit);
+
+#endif // OPTIMIZER_H
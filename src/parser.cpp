@@ -4,203 +4,648 @@
 // Description: Implementation of the parser for the .stkasm language with sections and directives.
 
 #include "parser.h"
+#include "lexer.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <iostream>
+#include <memory>
 #include <stdexcept>
-#include <algorithm> // For std::find_if
 
-// Helper function to trim whitespace from a string
-std::string trim(const std::string &str)
+// Input is read this many bytes at a time; only an unfinished last line is carried over.
+static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+namespace fs = std::filesystem;
+
+// Data addresses are u32 byte offsets.
+static constexpr uint64_t MAX_DATA_SIZE = UINT32_MAX;
+
+static std::runtime_error line_error(int line_num, const std::string &message)
 {
-    size_t first = str.find_first_not_of(" \t\n\r");
-    if (std::string::npos == first)
-        return str;
-    size_t last = str.find_last_not_of(" \t\n\r");
-    return str.substr(first, (last - first + 1));
+    return std::runtime_error("L" + std::to_string(line_num) + ": " + message);
 }
 
-// Helper to find a symbol in the symbol table being built.
-Symbol *find_symbol_in_table(std::vector<Symbol> &table, const std::string &name)
+namespace
 {
-    auto it = std::find_if(table.begin(), table.end(),
-                           [&](const Symbol &sym)
-                           { return sym.name == name; });
-    return (it != table.end()) ? &(*it) : nullptr;
-}
+// A name referenced before the end of input (by .global or a forward branch),
+// copied out of the source because the chunk it came from will be reused.
+struct PendingName
+{
+    uint32_t offset;
+    uint32_t length;
+    int line_num;
+};
 
-AssemblyUnit parse_file(const std::string &filepath)
+// A jmp/invoke whose target label had not been defined yet when it was parsed.
+struct Fixup
 {
-    std::ifstream file(filepath);
-    if (!file.is_open())
+    size_t instruction; // Index into AssemblyUnit::instructions.
+    PendingName label;
+};
+
+// An error found while parsing one chunk of a split source, kept until the
+// chunks before it are known to be error-free. line_num 0 means none.
+struct ChunkError
+{
+    int line_num = 0;
+    std::string message;
+
+    void keep_first(int line, std::string text)
     {
-        throw std::runtime_error("Cannot open file: " + filepath);
+        if (line_num == 0 || line < line_num)
+        {
+            line_num = line;
+            message = std::move(text);
+        }
     }
+};
 
-    AssemblyUnit unit;
-    std::string line;
-    int line_num = 0;
+class SourceParser;
+AssemblyUnit merge_chunks(std::vector<std::unique_ptr<SourceParser>> &chunks, ThreadPool &pool,
+                          AssemblyStats *stats);
+
+// The single-pass parser. Lines are fed in order by parse_lines; finish()
+// applies .global directives and resolves forward references.
+//
+// A parser can also take one chunk of a split source (see parse_buffer_parallel).
+// Its symbols, addresses and fixups are then local to the chunk, and it does not
+// know the section in effect where the chunk starts: lines that need a section
+// are accepted and the first of each kind is remembered, to be checked by
+// merge_chunks once the earlier chunks have been parsed.
+class SourceParser
+{
+public:
+    SourceParser(AssemblyStats *stats, const std::string &source_path)
+        : stats(stats), include_dir(include_dir_for(source_path)) {}
+    SourceParser(int first_line, bool inherits_section, const std::string &source_path)
+        : stats(nullptr), include_dir(include_dir_for(source_path)), line_num(first_line),
+          section(inherits_section ? CurrentSection::INHERITED : CurrentSection::UNKNOWN),
+          chunked(true) {}
+
+    void parse_lines(std::string_view text)
+    {
+        LineScanner lines(text);
+        std::string_view line;
+        while (lines.next(line))
+        {
+            line_num++;
+            if (!line.empty())
+                parse_line(line);
+        }
+    }
+
+    AssemblyUnit finish()
+    {
+        if (stats)
+            stats->lines += line_num;
+
+        // At end of input, process all the .global directives
+        PhaseTimer globals_timer(stats, Phase::GLOBALS);
+        apply_globals(unit.symbol_table);
+        globals_timer.stop();
+
+        // Resolve forward references now that every label has been seen.
+        PhaseTimer fixups_timer(stats, Phase::FIXUPS);
+        for (const Fixup &fixup : fixups)
+        {
+            SymbolId id = unit.symbol_table.find(name(fixup.label));
+            if (id == NO_SYMBOL)
+                throw line_error(fixup.label.line_num, "Undefined symbol '" + std::string(name(fixup.label)) + "'");
+            unit.instructions.operands[fixup.instruction] = static_cast<int32_t>(id);
+        }
+        place_zero_symbols();
+        return std::move(unit);
+    }
+
+    // Parses a whole chunk, keeping the first error instead of throwing it.
+    void parse_chunk(std::string_view text)
+    {
+        try
+        {
+            parse_lines(text);
+        }
+        catch (const std::runtime_error &e)
+        {
+            error.keep_first(line_num, e.what());
+        }
+    }
+
+private:
+    friend AssemblyUnit merge_chunks(std::vector<std::unique_ptr<SourceParser>> &chunks, ThreadPool &pool,
+                                     AssemblyStats *stats);
 
     enum class CurrentSection
     {
         TEXT,
         DATA,
-        UNKNOWN
+        UNKNOWN,
+        INHERITED // A chunk's lines before its first .text or .data.
     };
-    CurrentSection section = CurrentSection::UNKNOWN;
 
-    uint32_t instruction_address = 0;
-    uint32_t data_address = 0;
+    // Throws `message` unless the current section is `wanted`; in a chunk's
+    // inherited section, remembers the first such line instead.
+    void require_section(CurrentSection wanted, const char *message)
+    {
+        if (section == wanted)
+            return;
+        if (section != CurrentSection::INHERITED)
+            throw line_error(line_num, message);
+        ChunkError &first = wanted == CurrentSection::TEXT ? needs_text : needs_data;
+        if (first.line_num == 0)
+            first = {line_num, line_error(line_num, message).what()};
+    }
 
-    std::vector<std::string> globals_to_process;
+    SymbolId add_symbol(std::string_view symbol_name, Symbol::Type type, uint32_t address)
+    {
+        SymbolId id = unit.symbol_table.add(symbol_name, type, address);
+        if (id == NO_SYMBOL)
+            throw line_error(line_num, "Duplicate symbol " + std::string(symbol_name));
+        if (chunked)
+            symbol_lines.push_back(line_num);
+        return id;
+    }
+
+    void parse_line(std::string_view line);
+
+    static uint32_t round_up4(uint32_t size) { return static_cast<uint32_t>((static_cast<uint64_t>(size) + 3) & ~uint64_t(3)); }
 
-    // --- Pass 1: Identify all symbols (labels and data) and their locations. ---
-    while (std::getline(file, line))
+    uint32_t checked_data_size(uint32_t size, uint64_t added) const
     {
-        line_num++;
-        std::string cleaned_line = trim(line);
-        if (cleaned_line.empty() || cleaned_line[0] == '#')
-            continue;
+        if (size + added > MAX_DATA_SIZE)
+            throw line_error(line_num, "Data section exceeds 4 GiB");
+        return static_cast<uint32_t>(size + added);
+    }
 
-        // Handle directives
-        if (cleaned_line[0] == '.')
+    // Defines a .static, .array or .incbin symbol at the end of the initialized data.
+    void add_data_symbol(std::string_view var_name)
+    {
+        add_symbol(var_name, Symbol::Type::DATA, unit.data.size);
+        unit.data.entries++;
+    }
+
+    void append_value(int32_t value)
+    {
+        unit.data.size = checked_data_size(unit.data.size, 4);
+        std::vector<uint8_t> &bytes = unit.data.bytes;
+        size_t at = bytes.size();
+        bytes.resize(at + 4);
+        for (int i = 0; i < 4; i++)
+            bytes[at + i] = static_cast<uint8_t>(static_cast<uint32_t>(value) >> (i * 8));
+    }
+
+    // Appends every integer of a list separated by commas and/or whitespace.
+    void append_values(std::string_view list)
+    {
+        size_t i = 0;
+        while (i < list.size())
         {
-            std::stringstream ss(cleaned_line);
-            std::string directive;
-            ss >> directive;
-            if (directive == ".text")
-                section = CurrentSection::TEXT;
-            else if (directive == ".data")
-                section = CurrentSection::DATA;
-            else if (directive == ".global")
-            {
-                std::string label_name;
-                ss >> label_name;
-                globals_to_process.push_back(label_name);
-            }
-            else if (directive == ".static")
-            {
-                if (section != CurrentSection::DATA)
-                    throw std::runtime_error("L" + std::to_string(line_num) + ": .static can only be used in .data section");
-                std::string var_name;
-                ss >> var_name;
-                if (find_symbol_in_table(unit.symbol_table, var_name))
-                    throw std::runtime_error("L" + std::to_string(line_num) + ": Duplicate symbol " + var_name);
-                unit.symbol_table.push_back({var_name, Symbol::Type::DATA, Symbol::Binding::LOCAL, data_address});
-                data_address += 4; // All static data is 4 bytes for now
-            }
+            while (i < list.size() && is_value_separator(list[i]))
+                i++;
+            size_t start = i;
+            while (i < list.size() && !is_value_separator(list[i]))
+                i++;
+            if (i > start)
+                append_value(parse_int32(list.substr(start, i - start)));
         }
-        // Handle labels
-        else if (cleaned_line.back() == ':')
+    }
+    static bool is_value_separator(char c) { return c == ',' || c == ' ' || (c >= '\t' && c <= '\r'); }
+
+    // Relative .incbin paths are resolved against the including file's
+    // directory; without a source path (stdin, source text), the working directory.
+    static fs::path include_dir_for(const std::string &source_path)
+    {
+        if (source_path.empty() || source_path == "-")
+            return fs::path();
+        return fs::path(source_path).parent_path();
+    }
+
+    // Maps the file named by `path` (optionally in double quotes) and splices
+    // it into the initialized data, padded with zeros to 4 bytes.
+    void include_file(std::string_view path)
+    {
+        if (path.size() >= 2 && path.front() == '"' && path.back() == '"')
+            path = path.substr(1, path.size() - 2);
+        if (path.empty())
+            throw line_error(line_num, ".incbin needs a file name");
+        fs::path resolved(path);
+        if (resolved.is_relative())
+            resolved = include_dir / resolved;
+        std::shared_ptr<const MappedFile> file;
+        try
         {
-            if (section != CurrentSection::TEXT)
-                throw std::runtime_error("L" + std::to_string(line_num) + ": Labels can only be defined in .text section");
-            std::string label = cleaned_line.substr(0, cleaned_line.length() - 1);
-            if (find_symbol_in_table(unit.symbol_table, label))
-                throw std::runtime_error("L" + std::to_string(line_num) + ": Duplicate symbol " + label);
-            unit.symbol_table.push_back({label, Symbol::Type::TEXT, Symbol::Binding::LOCAL, instruction_address});
+            file = std::make_shared<const MappedFile>(MappedFile::open_read(resolved.string()));
         }
-        // Handle instructions (just count them in the first pass)
-        else
+        catch (const std::runtime_error &e)
         {
-            if (section != CurrentSection::TEXT)
-                throw std::runtime_error("L" + std::to_string(line_num) + ": Instructions can only be in .text section");
-            instruction_address++;
+            throw line_error(line_num, e.what());
         }
+        unit.data.size = checked_data_size(unit.data.size, file->size());
+        unit.data.includes.push_back({static_cast<uint32_t>(unit.data.bytes.size()), std::move(file)});
+        while (unit.data.size % 4 != 0)
+            append_padding();
+    }
+    void append_padding()
+    {
+        unit.data.bytes.push_back(0);
+        unit.data.size++;
+    }
+
+    // .space symbols were given offsets into the zero-filled region, which
+    // starts once the initialized data is complete.
+    void place_zero_symbols()
+    {
+        for (SymbolId id : zero_symbols)
+            unit.symbol_table[id].address += unit.data.size;
+        if (unit.data.zero_size > MAX_DATA_SIZE - unit.data.size)
+            throw std::runtime_error("Data section exceeds 4 GiB");
+    }
+
+    PendingName remember(std::string_view text)
+    {
+        PendingName pending{static_cast<uint32_t>(pending_names.size()), static_cast<uint32_t>(text.size()), line_num};
+        pending_names.append(text.data(), text.size());
+        return pending;
+    }
+    std::string_view name(const PendingName &pending) const
+    {
+        return std::string_view(pending_names.data() + pending.offset, pending.length);
     }
 
-    // After pass 1, process all the .global directives
-    for (const auto &name : globals_to_process)
+    void apply_globals(SymbolTable &table) const
     {
-        Symbol *sym = find_symbol_in_table(unit.symbol_table, name);
-        if (!sym)
-            throw std::runtime_error("Global symbol '" + name + "' was not defined.");
-        sym->binding = Symbol::Binding::GLOBAL;
+        for (const PendingName &global : globals_to_process)
+        {
+            SymbolId id = table.find(name(global));
+            if (id == NO_SYMBOL)
+                throw std::runtime_error("Global symbol '" + std::string(name(global)) + "' was not defined.");
+            table[id].binding = Symbol::Binding::GLOBAL;
+        }
+    }
+
+    // Resolves a branch target now if the label is already known, otherwise queues a fixup.
+    SymbolId resolve_or_defer(std::string_view label)
+    {
+        SymbolId id = unit.symbol_table.find(label);
+        if (id == NO_SYMBOL)
+            fixups.push_back({unit.instructions.size(), remember(label)});
+        return id;
     }
 
-    // --- Pass 2: Parse instructions and data values ---
-    file.clear();
-    file.seekg(0, std::ios::beg);
-    line_num = 0;
-    section = CurrentSection::UNKNOWN;
+    AssemblyStats *stats;
+    fs::path include_dir; // Empty: the working directory.
+    AssemblyUnit unit;
+    int line_num = 0;
+    CurrentSection section = CurrentSection::UNKNOWN;
+    uint32_t instruction_address = 0;
+    std::vector<SymbolId> zero_symbols; // Defined by .space, in definition order.
+    std::string pending_names; // Backing store for every PendingName.
+    std::vector<PendingName> globals_to_process;
+    std::vector<Fixup> fixups;
+
+    // Chunk state; see the class comment.
+    bool chunked = false;
+    std::vector<int> symbol_lines; // Definition line of each chunk-local symbol.
+    ChunkError error;              // First error thrown while parsing the chunk.
+    ChunkError needs_text;         // First label or instruction in the inherited section.
+    ChunkError needs_data;         // First data directive in the inherited section.
+};
 
-    while (std::getline(file, line))
+void SourceParser::parse_line(std::string_view line)
+{
+    // Handle directives
+    if (line[0] == '.')
     {
-        line_num++;
-        size_t comment_pos = line.find('#');
-        if (comment_pos != std::string::npos)
-            line = line.substr(0, comment_pos);
-        std::string cleaned_line = trim(line);
-        if (cleaned_line.empty() || cleaned_line.back() == ':')
-            continue;
+        TokenCursor tokens(line);
+        switch (lookup_keyword(tokens.next()))
+        {
+        case Keyword::TEXT:
+            section = CurrentSection::TEXT;
+            break;
+        case Keyword::DATA:
+            section = CurrentSection::DATA;
+            break;
+        case Keyword::GLOBAL:
+            globals_to_process.push_back(remember(tokens.next()));
+            break;
+        case Keyword::EXTERN:
+        {
+            SymbolId id = add_symbol(tokens.next(), Symbol::Type::EXTERN, 0);
+            unit.symbol_table[id].binding = Symbol::Binding::GLOBAL; // Always resolved by the linker.
+            break;
+        }
+        case Keyword::STATIC:
+        {
+            require_section(CurrentSection::DATA, ".static can only be used in .data section");
+            add_data_symbol(tokens.next());
+            append_value(parse_int32(tokens.next()));
+            break;
+        }
+        case Keyword::ARRAY:
+        {
+            require_section(CurrentSection::DATA, ".array can only be used in .data section");
+            add_data_symbol(tokens.next());
+            append_values(tokens.remainder());
+            break;
+        }
+        case Keyword::SPACE:
+        {
+            require_section(CurrentSection::DATA, ".space can only be used in .data section");
+            std::string_view var_name = tokens.next();
+            int32_t size = parse_int32(tokens.next());
+            if (size < 0)
+                throw line_error(line_num, ".space size must not be negative");
+            zero_symbols.push_back(add_symbol(var_name, Symbol::Type::DATA, unit.data.zero_size));
+            unit.data.zero_size = checked_data_size(unit.data.zero_size, round_up4(static_cast<uint32_t>(size)));
+            unit.data.entries++;
+            break;
+        }
+        case Keyword::INCBIN:
+        {
+            require_section(CurrentSection::DATA, ".incbin can only be used in .data section");
+            add_data_symbol(tokens.next());
+            include_file(tokens.remainder());
+            break;
+        }
+        default:
+            break; // Unknown directives are ignored.
+        }
+    }
+    // Handle labels
+    else if (line.back() == ':')
+    {
+        require_section(CurrentSection::TEXT, "Labels can only be defined in .text section");
+        add_symbol(line.substr(0, line.size() - 1), Symbol::Type::TEXT, instruction_address);
+    }
+    // Handle instructions
+    else
+    {
+        require_section(CurrentSection::TEXT, "Instructions can only be in .text section");
 
-        if (cleaned_line[0] == '.')
+        TokenCursor tokens(line);
+        std::string_view mnemonic = tokens.next();
+        switch (lookup_keyword(mnemonic))
         {
-            std::stringstream ss(cleaned_line);
-            std::string directive;
-            ss >> directive;
-            if (directive == ".text")
-                section = CurrentSection::TEXT;
-            else if (directive == ".data")
-                section = CurrentSection::DATA;
-            else if (directive == ".static")
-            {
-                std::string var_name;
-                int32_t value;
-                ss >> var_name >> value;
-                unit.data_entries.push_back({var_name, value});
-            }
+        case Keyword::ICONST:
+            unit.instructions.push(Opcode::ICONST, parse_int32(tokens.next()));
+            break;
+        case Keyword::IADD:
+            unit.instructions.push(Opcode::IADD);
+            break;
+        case Keyword::ISUB:
+            unit.instructions.push(Opcode::ISUB);
+            break;
+        case Keyword::IMUL:
+            unit.instructions.push(Opcode::IMUL);
+            break;
+        case Keyword::IDIV:
+            unit.instructions.push(Opcode::IDIV);
+            break;
+        case Keyword::JMP:
+        {
+            SymbolId target = resolve_or_defer(tokens.next());
+            unit.instructions.push(Opcode::JMP, static_cast<int32_t>(target));
+            break;
         }
-        else if (section == CurrentSection::TEXT)
+        case Keyword::INVOKE:
         {
-            std::stringstream ss(cleaned_line);
-            std::string mnemonic;
-            ss >> mnemonic;
+            SymbolId target = resolve_or_defer(tokens.next());
+            int32_t num_args = parse_int32(tokens.next());
+            unit.instructions.push(Opcode::INVOKE, static_cast<int32_t>(target), static_cast<uint8_t>(num_args));
+            break;
+        }
+        case Keyword::RET:
+            unit.instructions.push(Opcode::RET);
+            break;
+        default:
+            throw line_error(line_num, "Unknown mnemonic '" + std::string(mnemonic) + "'.");
+        }
+        instruction_address++;
+    }
+}
 
-            if (mnemonic == "iconst")
-            {
-                int32_t value;
-                ss >> value;
-                unit.instructions.push_back(std::make_unique<IConst>(value));
-            }
-            else if (mnemonic == "iadd")
-            {
-                unit.instructions.push_back(std::make_unique<IAdd>());
-            }
-            else if (mnemonic == "isub")
-            {
-                unit.instructions.push_back(std::make_unique<ISub>());
-            }
-            else if (mnemonic == "imul")
-            {
-                unit.instructions.push_back(std::make_unique<IMul>());
-            }
-            else if (mnemonic == "idiv")
-            {
-                unit.instructions.push_back(std::make_unique<IDiv>());
-            }
-            else if (mnemonic == "jmp")
-            {
-                std::string label;
-                ss >> label;
-                unit.instructions.push_back(std::make_unique<Jmp>(label));
-            }
-            else if (mnemonic == "invoke")
-            {
-                std::string label;
-                int num_args;
-                ss >> label >> num_args;
-                unit.instructions.push_back(std::make_unique<Invoke>(label, num_args));
-            }
-            else if (mnemonic == "ret")
+// Joins parsed chunks into the unit a single pass would have produced: the
+// same symbols in the same order, the same instructions and data, and the same
+// first error (short of a data section over 4 GiB, reported without a line).
+// A chunk's errors only count once every chunk before it merged cleanly;
+// within a chunk the earliest line wins.
+AssemblyUnit merge_chunks(std::vector<std::unique_ptr<SourceParser>> &chunks, ThreadPool &pool,
+                          AssemblyStats *stats)
+{
+    using CurrentSection = SourceParser::CurrentSection;
+    const size_t count = chunks.size();
+    AssemblyUnit unit;
+    std::vector<SymbolId> symbol_bases(count);
+    std::vector<uint32_t> instruction_bases(count), byte_bases(count);
+    std::vector<SymbolId> zero_symbols;
+
+    // 1. Symbols, in chunk order, rebased onto the chunk's first instruction
+    // and data address (or zero-fill offset, for .space). This is the only
+    // sequential step.
+    PhaseTimer merge_timer(stats, Phase::PARSE);
+    CurrentSection section = CurrentSection::UNKNOWN;
+    uint32_t instruction_address = 0;
+    uint64_t data_address = 0, zero_address = 0, byte_address = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        SourceParser &chunk = *chunks[k];
+        ChunkError first;
+        if (section != CurrentSection::TEXT && chunk.needs_text.line_num)
+            first.keep_first(chunk.needs_text.line_num, chunk.needs_text.message);
+        if (section != CurrentSection::DATA && chunk.needs_data.line_num)
+            first.keep_first(chunk.needs_data.line_num, chunk.needs_data.message);
+        if (chunk.error.line_num)
+            first.keep_first(chunk.error.line_num, chunk.error.message);
+
+        symbol_bases[k] = static_cast<SymbolId>(unit.symbol_table.size());
+        instruction_bases[k] = instruction_address;
+        byte_bases[k] = static_cast<uint32_t>(byte_address);
+        const SymbolTable &local = chunk.unit.symbol_table;
+        size_t next_zero = 0; // chunk.zero_symbols is in id order.
+        for (SymbolId id = 0; id < local.size(); id++)
+        {
+            const Symbol &sym = local[id];
+            bool zero_filled = next_zero < chunk.zero_symbols.size() && chunk.zero_symbols[next_zero] == id;
+            next_zero += zero_filled;
+            uint64_t base = sym.type == Symbol::Type::TEXT ? instruction_address
+                          : sym.type != Symbol::Type::DATA ? 0
+                          : zero_filled ? zero_address : data_address;
+            SymbolId merged = unit.symbol_table.add(local.name(sym), sym.type, static_cast<uint32_t>(sym.address + base));
+            if (merged == NO_SYMBOL)
             {
-                unit.instructions.push_back(std::make_unique<Ret>());
+                int line = chunk.symbol_lines[id];
+                first.keep_first(line, line_error(line, "Duplicate symbol " + std::string(local.name(sym))).what());
+                break;
             }
-            else
+            unit.symbol_table[merged].binding = sym.binding;
+            if (zero_filled)
+                zero_symbols.push_back(merged);
+        }
+        if (first.line_num)
+            throw std::runtime_error(first.message);
+
+        if (chunk.section != CurrentSection::INHERITED)
+            section = chunk.section;
+        const DataSection &data = chunk.unit.data;
+        instruction_address += chunk.instruction_address;
+        data_address += data.size;
+        zero_address += data.zero_size;
+        byte_address += data.bytes.size();
+        if (data_address + zero_address > MAX_DATA_SIZE)
+            throw std::runtime_error("Data section exceeds 4 GiB");
+        for (const DataInclude &include : data.includes)
+            unit.data.includes.push_back({include.at + byte_bases[k], include.file});
+        unit.data.entries += data.entries;
+    }
+    unit.data.size = static_cast<uint32_t>(data_address);
+    unit.data.zero_size = static_cast<uint32_t>(zero_address);
+    for (SymbolId id : zero_symbols)
+        unit.symbol_table[id].address += unit.data.size;
+    if (stats)
+        stats->lines += chunks.back()->line_num;
+    merge_timer.stop();
+
+    PhaseTimer globals_timer(stats, Phase::GLOBALS);
+    for (const auto &chunk : chunks)
+        chunk->apply_globals(unit.symbol_table);
+    globals_timer.stop();
+
+    // 2. Copy every chunk into place in parallel, moving branch operands from
+    // chunk-local to merged symbol ids and resolving the chunk's fixups, which
+    // may name labels defined in any chunk.
+    PhaseTimer fixups_timer(stats, Phase::FIXUPS);
+    InstructionStream &instrs = unit.instructions;
+    instrs.opcodes.resize(instruction_address);
+    instrs.operands.resize(instruction_address);
+    instrs.arg_counts.resize(instruction_address);
+    unit.data.bytes.resize(byte_address);
+    std::vector<ChunkError> errors(count);
+    pool.parallel_for(count, [&](size_t k) {
+        TaskTimer task_timer(stats, Phase::FIXUPS);
+        SourceParser &chunk = *chunks[k];
+        const InstructionStream &local = chunk.unit.instructions;
+        const uint32_t base = instruction_bases[k];
+        std::copy(local.opcodes.begin(), local.opcodes.end(), instrs.opcodes.begin() + base);
+        std::copy(local.arg_counts.begin(), local.arg_counts.end(), instrs.arg_counts.begin() + base);
+        for (size_t i = 0; i < local.size(); i++)
+        {
+            int32_t operand = local.operands[i];
+            if (is_branch(local.opcodes[i]) && operand != static_cast<int32_t>(NO_SYMBOL))
+                operand += static_cast<int32_t>(symbol_bases[k]);
+            instrs.operands[base + i] = operand;
+        }
+        for (const Fixup &fixup : chunk.fixups)
+        {
+            SymbolId id = unit.symbol_table.find(chunk.name(fixup.label));
+            if (id == NO_SYMBOL)
             {
-                throw std::runtime_error("L" + std::to_string(line_num) + ": Unknown mnemonic '" + mnemonic + "'.");
+                errors[k].keep_first(fixup.label.line_num, line_error(fixup.label.line_num, "Undefined symbol '" +
+                                                                      std::string(chunk.name(fixup.label)) + "'").what());
+                break;
             }
+            instrs.operands[base + fixup.instruction] = static_cast<int32_t>(id);
         }
+        const std::vector<uint8_t> &bytes = chunk.unit.data.bytes;
+        std::copy(bytes.begin(), bytes.end(), unit.data.bytes.begin() + byte_bases[k]);
+    });
+    for (const ChunkError &error : errors)
+        if (error.line_num)
+            throw std::runtime_error(error.message);
+    return unit;
+}
+} // namespace
+
+AssemblyUnit parse_file(const std::string &filepath, AssemblyStats *stats)
+{
+    if (filepath == "-")
+        return parse_stream(std::cin, stats);
+
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Cannot open file: " + filepath);
     }
+    return parse_stream(file, stats, filepath);
+}
 
-    return unit;
-}
\ No newline at end of file
+AssemblyUnit parse_stream(std::istream &in, AssemblyStats *stats, const std::string &source_path)
+{
+    SourceParser parser(stats, source_path);
+    PhaseTimer parse_timer(stats, Phase::PARSE);
+    std::vector<char> buffer(CHUNK_SIZE);
+    size_t carried = 0; // Bytes of an unfinished line kept from the previous chunk.
+    for (;;)
+    {
+        if (carried == buffer.size())
+            buffer.resize(buffer.size() * 2); // A single line longer than the buffer.
+        in.read(buffer.data() + carried, static_cast<std::streamsize>(buffer.size() - carried));
+        size_t filled = carried + static_cast<size_t>(in.gcount());
+        if (in.bad())
+            throw std::runtime_error("Error reading input.");
+        bool at_end = !in;
+
+        std::string_view text(buffer.data(), filled);
+        size_t complete = filled;
+        if (!at_end)
+        {
+            size_t last_newline = text.rfind('\n');
+            complete = last_newline == std::string_view::npos ? 0 : last_newline + 1;
+        }
+        parser.parse_lines(text.substr(0, complete));
+        if (at_end)
+            break;
+        carried = filled - complete;
+        std::copy(buffer.begin() + complete, buffer.begin() + filled, buffer.begin());
+    }
+    parse_timer.stop();
+    return parser.finish();
+}
+
+AssemblyUnit parse_buffer(std::string_view source, AssemblyStats *stats, const std::string &source_path)
+{
+    SourceParser parser(stats, source_path);
+    PhaseTimer parse_timer(stats, Phase::PARSE);
+    parser.parse_lines(source);
+    parse_timer.stop();
+    return parser.finish();
+}
+
+AssemblyUnit parse_buffer_parallel(std::string_view source, ThreadPool &pool, AssemblyStats *stats,
+                                   size_t chunk_bytes, const std::string &source_path)
+{
+    // Chunks end just after a newline, so no line is split between two of them.
+    std::vector<std::string_view> pieces;
+    for (size_t start = 0; start < source.size();)
+    {
+        size_t end = std::min(source.size(), start + std::max<size_t>(chunk_bytes, 1));
+        if (end < source.size())
+        {
+            size_t newline = source.find('\n', end - 1);
+            end = newline == std::string_view::npos ? source.size() : newline + 1;
+        }
+        pieces.push_back(source.substr(start, end - start));
+        start = end;
+    }
+    if (pieces.size() < 2)
+        return parse_buffer(source, stats, source_path);
+
+    PhaseTimer parse_timer(stats, Phase::PARSE);
+    // Every chunk but the last ends with a newline, so the lines before chunk k
+    // are the newlines in chunks 0 .. k - 1.
+    std::vector<int> first_lines(pieces.size());
+    pool.parallel_for(pieces.size() - 1, [&](size_t k) {
+        TaskTimer task_timer(stats, Phase::PARSE);
+        first_lines[k + 1] = static_cast<int>(std::count(pieces[k].begin(), pieces[k].end(), '\n'));
+    });
+    for (size_t k = 1; k < pieces.size(); k++)
+        first_lines[k] += first_lines[k - 1];
+
+    std::vector<std::unique_ptr<SourceParser>> chunks(pieces.size());
+    pool.parallel_for(pieces.size(), [&](size_t k) {
+        TaskTimer task_timer(stats, Phase::PARSE);
+        chunks[k] = std::make_unique<SourceParser>(first_lines[k], k > 0, source_path);
+        chunks[k]->parse_chunk(pieces[k]);
+    });
+    parse_timer.stop();
+    return merge_chunks(chunks, pool, stats);
+}
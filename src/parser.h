@@ -7,11 +7,43 @@
 #define PARSER_H
 
 #include "structures.h"
+#include "stats.h"
 #include <string>
+#include <string_view>
+#include <istream>
+
+class ThreadPool;
+
+// Sources at least this large are worth splitting across threads.
+constexpr size_t PARALLEL_PARSE_MIN_BYTES = 4 << 20;
+constexpr size_t PARALLEL_CHUNK_BYTES = 1 << 20;
 
 // Parses a .stkasm file and returns a complete AssemblyUnit object,
 // which contains instructions, data, and symbol table information.
-// Throws std::runtime_error on failure.
-AssemblyUnit parse_file(const std::string &filepath);
+// A filepath of "-" reads the source from standard input. In every parse
+// function, a relative .incbin path is resolved against the directory of
+// `source_path` (here `filepath`), or the working directory when there is none.
+// Throws std::runtime_error on failure. Phase times go to `stats` when given.
+AssemblyUnit parse_file(const std::string &filepath, AssemblyStats *stats = nullptr);
+
+// Parses .stkasm source from an already-open stream in a single pass,
+// reading it in fixed-size chunks. References to labels that are not yet
+// defined are recorded as fixups and resolved once the end of input is reached.
+AssemblyUnit parse_stream(std::istream &in, AssemblyStats *stats = nullptr, const std::string &source_path = {});
+
+// Same as parse_stream, for source already held in memory; lines are
+// scanned in place without copying.
+AssemblyUnit parse_buffer(std::string_view source, AssemblyStats *stats = nullptr,
+                          const std::string &source_path = {});
+
+// Same as parse_buffer, with the source split at line boundaries into chunks of
+// about `chunk_bytes` that are parsed on `pool`, each with its own symbol table
+// and fixups. The chunks are then merged: symbols in order, with addresses
+// rebased by the prefix sums of the chunks' instruction and data counts, and
+// cross-chunk references resolved in a parallel patch step. The unit, and the
+// first error on failure, are the same as parse_buffer's. Must not be called
+// from a task running on `pool`.
+AssemblyUnit parse_buffer_parallel(std::string_view source, ThreadPool &pool, AssemblyStats *stats = nullptr,
+                                   size_t chunk_bytes = PARALLEL_CHUNK_BYTES, const std::string &source_path = {});
 
 #endif // PARSER_H
\ No newline at end of file
@@ -0,0 +1,231 @@
+// File: profiler.cpp
+// Owner: Team
+// Role: Virtual Machine
+// Description: Calling-context tree, symbol lookup and report writers for the profiler.
+
+#include "profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+std::vector<ProfileSymbol> read_symbol_file(const std::string &path) {
+    std::vector<ProfileSymbol> symbols;
+    std::ifstream in(path);
+    if (!in) {
+        return symbols;
+    }
+    std::string line;
+    for (int line_num = 1; std::getline(in, line); line_num++) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        ProfileSymbol sym;
+        char type = 0;
+        if (!(fields >> std::hex >> sym.address >> type >> sym.name) || std::string("TtDd").find(type) == std::string::npos) {
+            throw std::runtime_error("Malformed line " + std::to_string(line_num) + " in " + path);
+        }
+        sym.code = type == 'T' || type == 't';
+        sym.global = type == 'T' || type == 'D';
+        symbols.push_back(std::move(sym));
+    }
+    return symbols;
+}
+
+namespace {
+
+std::string hex_address(uint32_t address) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "0x%x", address);
+    return text;
+}
+
+void print_json_string(std::FILE *out, const std::string &text) {
+    std::fputc('"', out);
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', out);
+            std::fputc(c, out);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            std::fprintf(out, "\\u%04x", c);
+        } else {
+            std::fputc(c, out);
+        }
+    }
+    std::fputc('"', out);
+}
+
+// Names instruction indices after the code labels of a symbol file. Where
+// several labels share an address, a global one wins; addresses without a
+// label are printed in hex.
+class SymbolNames {
+public:
+    SymbolNames(const Program &program, const std::vector<ProfileSymbol> &symbols) : program(program) {
+        for (const ProfileSymbol &sym : symbols) {
+            if (sym.code) labels.push_back(&sym);
+        }
+        std::stable_sort(labels.begin(), labels.end(), [](const ProfileSymbol *a, const ProfileSymbol *b) {
+            return a->address != b->address ? a->address < b->address : a->global > b->global;
+        });
+    }
+
+    // The function starting at instruction `index`.
+    const std::string &function(uint32_t index) {
+        auto cached = functions.find(index);
+        if (cached != functions.end()) {
+            return cached->second;
+        }
+        const ProfileSymbol *label = first_at_or_before(program.offsets[index]);
+        std::string name = label && label->address == program.offsets[index]
+                               ? label->name
+                               : "fn@" + hex_address(program.offsets[index]);
+        return functions.emplace(index, std::move(name)).first->second;
+    }
+
+    // "label+offset" from the nearest label at or before instruction `index`.
+    std::string location(uint32_t index) const {
+        uint32_t address = program.offsets[index];
+        const ProfileSymbol *label = first_at_or_before(address);
+        if (!label) {
+            return hex_address(address);
+        }
+        return address == label->address ? label->name : label->name + "+" + std::to_string(address - label->address);
+    }
+
+private:
+    const ProfileSymbol *first_at_or_before(uint32_t address) const {
+        auto after = std::upper_bound(labels.begin(), labels.end(), address,
+                                      [](uint32_t a, const ProfileSymbol *sym) { return a < sym->address; });
+        if (after == labels.begin()) {
+            return nullptr;
+        }
+        uint32_t found = after[-1]->address;
+        return *std::lower_bound(labels.begin(), after, found,
+                                 [](const ProfileSymbol *sym, uint32_t a) { return sym->address < a; });
+    }
+
+    const Program &program;
+    std::vector<const ProfileSymbol *> labels;
+    std::unordered_map<uint32_t, std::string> functions;
+};
+
+// Entries sorted by descending weight, ties in key order.
+template <typename Key>
+std::vector<std::pair<Key, uint64_t>> by_weight(const std::map<Key, uint64_t> &totals) {
+    std::vector<std::pair<Key, uint64_t>> sorted(totals.begin(), totals.end());
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const auto &a, const auto &b) { return a.second > b.second; });
+    return sorted;
+}
+
+} // namespace
+
+// Hottest instructions listed in the JSON summary.
+constexpr size_t HOT_INSTRUCTIONS = 20;
+
+Profiler::Profiler(const Program &program, uint32_t period)
+    : program(program), code(program.code.data()), period(std::max<uint32_t>(period, 1)),
+      countdown(this->period), counts(program.code.size(), 0) {
+    nodes.push_back({program.entry, NO_NODE, NO_NODE, NO_NODE});
+}
+
+uint32_t Profiler::child(uint32_t parent, uint32_t function) {
+    for (uint32_t node = nodes[parent].first_child; node != NO_NODE; node = nodes[node].next_sibling) {
+        if (nodes[node].function == function) {
+            return node;
+        }
+    }
+    nodes.push_back({function, parent, NO_NODE, nodes[parent].first_child});
+    uint32_t node = static_cast<uint32_t>(nodes.size() - 1);
+    nodes[parent].first_child = node;
+    return node;
+}
+
+uint64_t Profiler::samples() const {
+    uint64_t total = 0;
+    for (const Node &node : nodes) total += node.self;
+    return total;
+}
+
+void Profiler::write_folded(std::FILE *out, const std::vector<ProfileSymbol> &symbols) const {
+    SymbolNames names(program, symbols);
+    std::vector<uint32_t> path;
+    for (uint32_t n = 0; n < nodes.size(); n++) {
+        if (nodes[n].self == 0) continue;
+        path.clear();
+        for (uint32_t at = n; at != NO_NODE; at = nodes[at].parent) {
+            path.push_back(nodes[at].function);
+        }
+        for (size_t i = path.size(); i-- > 0;) {
+            std::fputs(names.function(path[i]).c_str(), out);
+            std::fputc(i ? ';' : ' ', out);
+        }
+        std::fprintf(out, "%llu\n", static_cast<unsigned long long>(nodes[n].self));
+    }
+}
+
+void Profiler::write_json(std::FILE *out, const std::vector<ProfileSymbol> &symbols) const {
+    SymbolNames names(program, symbols);
+    std::map<uint8_t, uint64_t> opcodes;
+    std::vector<uint32_t> hot;
+    for (uint32_t i = 0; i < counts.size(); i++) {
+        if (counts[i] == 0) continue;
+        opcodes[static_cast<uint8_t>(code[i].op)] += counts[i];
+        hot.push_back(i);
+    }
+    std::stable_sort(hot.begin(), hot.end(), [&](uint32_t a, uint32_t b) { return counts[a] > counts[b]; });
+    hot.resize(std::min(hot.size(), HOT_INSTRUCTIONS));
+
+    std::map<uint32_t, uint64_t> self, calls;
+    std::map<std::pair<uint32_t, uint32_t>, uint64_t> edges;
+    for (const Node &node : nodes) {
+        self[node.function] += node.self;
+        calls[node.function] += node.calls;
+        if (node.parent != NO_NODE) {
+            edges[{nodes[node.parent].function, node.function}] += node.calls;
+        }
+    }
+
+    std::fprintf(out, "{\n  \"sampling_period\": %u,\n  \"samples\": %llu,\n  \"opcodes\": [", period,
+                 static_cast<unsigned long long>(samples()));
+    const char *separator = "\n";
+    for (const auto &entry : by_weight(opcodes)) {
+        std::fprintf(out, "%s    {\"opcode\": \"%s\", \"samples\": %llu}", separator,
+                     opcode_name(static_cast<Opcode>(entry.first)), static_cast<unsigned long long>(entry.second));
+        separator = ",\n";
+    }
+
+    std::fprintf(out, "\n  ],\n  \"functions\": [");
+    separator = "\n";
+    for (const auto &entry : by_weight(self)) {
+        std::fprintf(out, "%s    {\"name\": ", separator);
+        print_json_string(out, names.function(entry.first));
+        std::fprintf(out, ", \"address\": %u, \"calls\": %llu, \"self\": %llu}", program.offsets[entry.first],
+                     static_cast<unsigned long long>(calls[entry.first]),
+                     static_cast<unsigned long long>(entry.second));
+        separator = ",\n";
+    }
+
+    std::fprintf(out, "\n  ],\n  \"call_edges\": [");
+    separator = "\n";
+    for (const auto &entry : by_weight(edges)) {
+        std::fprintf(out, "%s    {\"caller\": ", separator);
+        print_json_string(out, names.function(entry.first.first));
+        std::fprintf(out, ", \"callee\": ");
+        print_json_string(out, names.function(entry.first.second));
+        std::fprintf(out, ", \"calls\": %llu}", static_cast<unsigned long long>(entry.second));
+        separator = ",\n";
+    }
+
+    std::fprintf(out, "\n  ],\n  \"hot_instructions\": [");
+    separator = "\n";
+    for (uint32_t i : hot) {
+        std::fprintf(out, "%s    {\"address\": %u, \"location\": ", separator, program.offsets[i]);
+        print_json_string(out, names.location(i));
+        std::fprintf(out, ", \"opcode\": \"%s\", \"samples\": %llu}", opcode_name(code[i].op),
+                     static_cast<unsigned long long>(counts[i]));
+        separator = ",\n";
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+}
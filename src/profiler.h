@@ -0,0 +1,96 @@
+// File: profiler.h
+// Owner: Team
+// Role: Virtual Machine
+// Description: Execution profiler for the interpreter. Counts executed instructions,
+//              or samples one in every N, by address and by calling context, and
+//              reports them per opcode, per function and per invoke edge, as a JSON
+//              summary and as folded stacks for flamegraph.pl.
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "vm.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// A named address from the file `linker --symbols` writes next to the program.
+struct ProfileSymbol
+{
+    uint32_t address; // Byte offset from the start of the code section.
+    bool code;
+    bool global;
+    std::string name;
+};
+
+// Reads a --symbols file. Returns an empty list if `path` does not exist;
+// throws std::runtime_error on a malformed line.
+std::vector<ProfileSymbol> read_symbol_file(const std::string &path);
+
+// Attach to VmOptions::profiler to profile a run; the hooks below are called by
+// the interpreter loops, which are instantiated without them otherwise.
+// Functions are identified by the instruction index invoke jumps to, and
+// calling contexts form a tree rooted at the entry function, so a recursive
+// call opens a new node per level. Runs accumulate into the same profile.
+class Profiler {
+public:
+    // Records every `period`-th instruction executed; 1 records them all.
+    explicit Profiler(const Program &program, uint32_t period = 1);
+
+    // Hooks, in execution order: start() once per run, then on_instruction()
+    // before every instruction, on_invoke() for every interpreted call and
+    // on_return() for every ret except the entry function's.
+    void start() {
+        current = 0;
+        nodes[0].calls++;
+    }
+    void on_instruction(const DecodedInstruction *ip) {
+        if (--countdown != 0) return;
+        countdown = period;
+        counts[ip - code]++;
+        nodes[current].self++;
+    }
+    void on_invoke(uint32_t callee) {
+        current = child(current, callee);
+        nodes[current].calls++;
+    }
+    void on_return() { current = nodes[current].parent; }
+
+    uint32_t sampling_period() const { return period; }
+    uint64_t samples() const; // Instructions recorded so far.
+
+    // One "entry;caller;callee weight" line per calling context that recorded
+    // anything, in the order the contexts were first entered; functions are
+    // named from `symbols`.
+    void write_folded(std::FILE *out, const std::vector<ProfileSymbol> &symbols) const;
+
+    // Totals per opcode, per function and per invoke edge, and the hottest
+    // instructions, each sorted by weight.
+    void write_json(std::FILE *out, const std::vector<ProfileSymbol> &symbols) const;
+
+private:
+    // A calling context: `function` invoked from the context `parent`.
+    struct Node
+    {
+        uint32_t function;     // Instruction index of its first instruction.
+        uint32_t parent;
+        uint32_t first_child;  // Children are a singly linked list; NO_NODE ends it.
+        uint32_t next_sibling;
+        uint64_t self = 0;     // Instructions recorded while it was innermost.
+        uint64_t calls = 0;    // Times it was entered.
+    };
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    uint32_t child(uint32_t parent, uint32_t function);
+
+    const Program &program;
+    const DecodedInstruction *code;
+    uint32_t period;
+    uint32_t countdown;
+    std::vector<uint64_t> counts; // Per instruction index.
+    std::vector<Node> nodes;      // nodes[0] is the entry function.
+    uint32_t current = 0;
+};
+
+#endif // PROFILER_H
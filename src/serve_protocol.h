@@ -0,0 +1,127 @@
+// File: serve_protocol.h
+// Owner: Team
+// Role: Assembler Server
+// Description: Framing shared by `assembler --serve` and the asmclient tool. Every
+//              message is a little-endian u32 body length followed by the body.
+//
+//              request body:  u8 kind, u8 flags, then the source path (PATH) or
+//                             the source text itself (SOURCE); empty for SHUTDOWN
+//              response body: u8 status, then the STAO object (OK) or an error
+//                             message (ERROR)
+//
+//              A connection may carry any number of requests; each is answered
+//              in order before the next is read.
+
+#ifndef SERVE_PROTOCOL_H
+#define SERVE_PROTOCOL_H
+
+#include "byte_io.h"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+enum class ServeRequest : uint8_t {
+    PATH = 0,     // Assemble the file at this path, as seen by the server.
+    SOURCE = 1,   // Assemble the source text carried in the request.
+    SHUTDOWN = 2  // Stop accepting connections and exit once in-flight requests finish.
+};
+
+enum class ServeStatus : uint8_t {
+    OK = 0,
+    ERROR = 1
+};
+
+constexpr uint8_t SERVE_FLAG_OPTIMIZE = 1; // Same as -O.
+constexpr uint8_t SERVE_FLAG_VERIFY = 2;   // Same as --verify.
+constexpr uint32_t SERVE_MAX_FRAME = 1u << 30;
+
+// Writes or reads exactly `length` bytes, retrying short transfers and EINTR.
+// read_exactly returns false on end of stream or error.
+inline bool write_exactly(int fd, const void *data, size_t length) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    while (length > 0) {
+        ssize_t n = ::send(fd, p, length, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+inline bool read_exactly(int fd, void *data, size_t length) {
+    uint8_t *p = static_cast<uint8_t *>(data);
+    while (length > 0) {
+        ssize_t n = ::recv(fd, p, length, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Sends one frame whose body is `head` followed by `payload`, without joining them.
+inline bool send_frame(int fd, const uint8_t *head, size_t head_length, const void *payload, size_t payload_length) {
+    uint8_t length[4];
+    write_u32(length, static_cast<uint32_t>(head_length + payload_length));
+    return write_exactly(fd, length, 4) && write_exactly(fd, head, head_length) &&
+           write_exactly(fd, payload, payload_length);
+}
+
+// Receives one frame body. Returns false at a clean end of stream; throws
+// std::runtime_error on a truncated or oversized frame.
+inline bool receive_frame(int fd, std::vector<uint8_t> &body) {
+    uint8_t length[4];
+    ssize_t n;
+    do {
+        n = ::recv(fd, length, 1, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    if (!read_exactly(fd, length + 1, 3)) {
+        throw std::runtime_error("Truncated frame.");
+    }
+    uint32_t size = read_u32(length);
+    if (size > SERVE_MAX_FRAME) {
+        throw std::runtime_error("Frame of " + std::to_string(size) + " bytes exceeds the limit.");
+    }
+    body.resize(size);
+    if (!read_exactly(fd, body.data(), size)) {
+        throw std::runtime_error("Truncated frame.");
+    }
+    return true;
+}
+
+// Fills a Unix socket address. Throws std::runtime_error if the path is too long.
+inline sockaddr_un unix_address(const std::string &path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path is too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+// Connects to a server socket. Returns -1 (with errno set) on failure.
+inline int connect_unix(const std::string &path) {
+    sockaddr_un address = unix_address(path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+#endif // SERVE_PROTOCOL_H
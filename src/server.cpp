@@ -0,0 +1,240 @@
+// File: server.cpp
+// Owner: Team
+// Role: Assembler Server
+// Description: Accept loop, per-connection request handling and the in-memory
+//              object cache behind `assembler --serve`.
+
+#include "server.h"
+#include "content_hash.h"
+#include "driver.h"
+#include "mapped_file.h"
+#include "serve_protocol.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <csignal>
+#include <fcntl.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <stdexcept>
+#include <string_view>
+#include <sys/time.h>
+#include <unordered_map>
+#include <vector>
+
+using ObjectBytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+// Idle connections are dropped after this long so they cannot pin a worker.
+static constexpr int IDLE_TIMEOUT_SECONDS = 60;
+
+// Least-recently-used cache of emitted objects, bounded by total size.
+class ObjectMemo {
+public:
+    explicit ObjectMemo(uint64_t max_bytes) : max_bytes(max_bytes) {}
+
+    ObjectBytes find(uint64_t key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it == entries.end()) return nullptr;
+        order.splice(order.begin(), order, it->second.position);
+        return it->second.object;
+    }
+
+    void insert(uint64_t key, ObjectBytes object) {
+        if (object->size() > max_bytes) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries.count(key)) return; // Another worker assembled the same source.
+        order.push_front(key);
+        bytes += object->size();
+        entries.emplace(key, Entry{std::move(object), order.begin()});
+        while (bytes > max_bytes) {
+            auto victim = entries.find(order.back());
+            bytes -= victim->second.object->size();
+            entries.erase(victim);
+            order.pop_back();
+        }
+    }
+
+private:
+    struct Entry {
+        ObjectBytes object;
+        std::list<uint64_t>::iterator position; // In `order`, most recent first.
+    };
+
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::list<uint64_t> order;
+    uint64_t bytes = 0;
+    uint64_t max_bytes;
+};
+
+// Written by the signal handler and by SHUTDOWN requests to wake the accept loop.
+static int wake_pipe[2] = {-1, -1};
+
+static void on_stop_signal(int) {
+    char byte = 0;
+    ssize_t ignored = ::write(wake_pipe[1], &byte, 1);
+    (void)ignored;
+}
+
+namespace {
+struct ServerState {
+    explicit ServerState(uint64_t memo_bytes) : memo(memo_bytes) {}
+
+    ObjectMemo memo;
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> memo_hits{0};
+    std::atomic<uint64_t> errors{0};
+};
+} // namespace
+
+// `source_path` is set for PATH requests; relative .incbin paths in SOURCE
+// requests resolve against the server's working directory.
+static ObjectBytes assemble(ServerState &state, std::string_view source, uint8_t flags,
+                            const std::string &source_path = {}) {
+    ContentHash hash(ASSEMBLER_VERSION);
+    hash.update(&flags, 1);
+    hash.update(source.data(), source.size());
+    uint64_t key = hash.digest();
+    if (ObjectBytes object = state.memo.find(key)) {
+        state.memo_hits++;
+        return object;
+    }
+    AssemblerOptions options;
+    options.optimize = (flags & SERVE_FLAG_OPTIMIZE) != 0;
+    options.verify = (flags & SERVE_FLAG_VERIFY) != 0;
+    AssemblyResult result;
+    auto object = std::make_shared<const std::vector<uint8_t>>(assemble_source(source, options, result, source_path));
+    if (result.included_files == 0) { // The key covers only the source text.
+        state.memo.insert(key, object);
+    }
+    return object;
+}
+
+static bool respond(int fd, ServeStatus status, const void *payload, size_t length) {
+    uint8_t head = static_cast<uint8_t>(status);
+    return send_frame(fd, &head, 1, payload, length);
+}
+
+// Answers requests on one connection until the client closes it.
+static void handle_connection(int fd, ServerState &state) {
+    std::vector<uint8_t> body;
+    try {
+        while (receive_frame(fd, body)) {
+            state.requests++;
+            if (body.size() < 2) {
+                state.errors++;
+                static const char message[] = "Malformed request.";
+                if (!respond(fd, ServeStatus::ERROR, message, sizeof(message) - 1)) break;
+                continue;
+            }
+            ServeRequest kind = static_cast<ServeRequest>(body[0]);
+            uint8_t flags = body[1];
+            std::string_view payload(reinterpret_cast<const char *>(body.data() + 2), body.size() - 2);
+            if (kind == ServeRequest::SHUTDOWN) {
+                respond(fd, ServeStatus::OK, nullptr, 0);
+                on_stop_signal(0);
+                break;
+            }
+
+            ObjectBytes object;
+            std::string error;
+            try {
+                if (kind == ServeRequest::PATH) {
+                    std::string path(payload);
+                    MappedFile source = MappedFile::open_read(path);
+                    object = assemble(state, std::string_view(reinterpret_cast<const char *>(source.data()),
+                                                              source.size()), flags, path);
+                } else if (kind == ServeRequest::SOURCE) {
+                    object = assemble(state, payload, flags);
+                } else {
+                    error = "Unknown request kind " + std::to_string(body[0]) + ".";
+                }
+            } catch (const std::exception &e) {
+                error = e.what();
+            }
+            bool sent = error.empty() ? respond(fd, ServeStatus::OK, object->data(), object->size())
+                                      : respond(fd, ServeStatus::ERROR, error.data(), error.size());
+            if (!error.empty()) state.errors++;
+            if (!sent) break;
+        }
+    } catch (const std::exception &) {
+        // A malformed frame or a broken connection only ends this connection.
+    }
+    ::close(fd);
+}
+
+// Binds and listens on `path`, replacing a socket file no server is listening on.
+static int listen_on(const std::string &path) {
+    sockaddr_un address = unix_address(path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+    }
+    int status = ::bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+    if (status < 0 && errno == EADDRINUSE) {
+        int probe = connect_unix(path);
+        if (probe >= 0) {
+            ::close(probe);
+            ::close(fd);
+            throw std::runtime_error("A server is already listening on " + path);
+        }
+        ::unlink(path.c_str());
+        status = ::bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+    }
+    if (status < 0 || ::listen(fd, SOMAXCONN) < 0) {
+        std::string reason = std::strerror(errno);
+        ::close(fd);
+        throw std::runtime_error("Cannot listen on " + path + ": " + reason);
+    }
+    return fd;
+}
+
+ServerStats serve(const std::string &socket_path, const ServerOptions &options) {
+    int listener = listen_on(socket_path);
+    if (::pipe2(wake_pipe, O_CLOEXEC | O_NONBLOCK) < 0) {
+        ::close(listener);
+        throw std::runtime_error("Cannot create wake-up pipe: " + std::string(std::strerror(errno)));
+    }
+    struct sigaction action {};
+    action.sa_handler = on_stop_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    struct sigaction old_int, old_term;
+    sigaction(SIGINT, &action, &old_int);
+    sigaction(SIGTERM, &action, &old_term);
+
+    ServerState state(options.memo_bytes);
+    {
+        ThreadPool pool(options.jobs);
+        pollfd fds[2] = {{listener, POLLIN, 0}, {wake_pipe[0], POLLIN, 0}};
+        for (;;) {
+            if (::poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (fds[1].revents) break;
+            int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) continue; // E.g. the client gave up before we accepted.
+            timeval timeout{IDLE_TIMEOUT_SECONDS, 0};
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            pool.submit([fd, &state] { handle_connection(fd, state); });
+        }
+        ::close(listener);
+        ::unlink(socket_path.c_str());
+        pool.wait(); // Let in-flight requests finish.
+    }
+
+    sigaction(SIGINT, &old_int, nullptr);
+    sigaction(SIGTERM, &old_term, nullptr);
+    ::close(wake_pipe[0]);
+    ::close(wake_pipe[1]);
+    wake_pipe[0] = wake_pipe[1] = -1;
+
+    ServerStats stats;
+    stats.requests = state.requests;
+    stats.memo_hits = state.memo_hits;
+    stats.errors = state.errors;
+    return stats;
+}
@@ -0,0 +1,34 @@
+// File: server.h
+// Owner: Team
+// Role: Assembler Server
+// Description: `assembler --serve`: a long-running assembler that answers framed
+//              requests on a Unix domain socket (see serve_protocol.h).
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstdint>
+#include <string>
+
+struct ServerOptions
+{
+    unsigned jobs = 0;                  // Connections handled concurrently (0 = one per core).
+    uint64_t memo_bytes = 256ULL << 20; // Budget of the in-memory object cache.
+};
+
+struct ServerStats
+{
+    uint64_t requests = 0;
+    uint64_t memo_hits = 0; // Requests answered from the in-memory object cache.
+    uint64_t errors = 0;    // Requests answered with an error.
+};
+
+// Listens on `socket_path` and serves requests on a thread pool until SIGINT,
+// SIGTERM or a SHUTDOWN request, then finishes in-flight requests and removes
+// the socket. A stale socket file is replaced; a live one is an error. Objects
+// are cached in memory by a hash of the source text and flags, so a repeated
+// request skips parsing and emission. Throws std::runtime_error if the socket
+// cannot be set up.
+ServerStats serve(const std::string &socket_path, const ServerOptions &options = {});
+
+#endif // SERVER_H
@@ -0,0 +1,100 @@
+// File: stak_image.cpp
+// Owner: Team
+// Role: Executable Format
+// Description: The STAK code decoder and the PIC image writer.
+
+#include "stak_image.h"
+#include "byte_io.h"
+#include "mapped_file.h"
+#include <cstring>
+#include <stdexcept>
+
+static uint64_t page_align(uint64_t offset) {
+    return (offset + STAK_PIC_PAGE_SIZE - 1) & ~uint64_t(STAK_PIC_PAGE_SIZE - 1);
+}
+
+DecodedCode decode_code(const uint8_t *code, uint32_t code_size, uint32_t entry_address, const std::string &path) {
+    // index_at maps each instruction boundary (and the end of the code) to its
+    // instruction index.
+    DecodedCode decoded;
+    std::vector<uint32_t> index_at(static_cast<size_t>(code_size) + 1, UINT32_MAX);
+    std::vector<uint32_t> relative; // Instructions whose operand is a displacement.
+    for (uint32_t offset = 0; offset < code_size;) {
+        Opcode op = static_cast<Opcode>(code[offset]);
+        uint32_t size = encoded_size(op);
+        if (size == 0 || offset + size > code_size) {
+            throw std::runtime_error("Invalid instruction at code offset " + std::to_string(offset) + " in " + path);
+        }
+        index_at[offset] = static_cast<uint32_t>(decoded.code.size());
+        if (is_relative_branch(op)) {
+            relative.push_back(static_cast<uint32_t>(decoded.code.size()));
+        }
+        decoded.code.push_back(decode_instruction(code + offset));
+        decoded.offsets.push_back(offset);
+        offset += size;
+    }
+    index_at[code_size] = static_cast<uint32_t>(decoded.code.size());
+
+    // Branch targets become instruction indices, so they index the records directly.
+    size_t count = decoded.code.size();
+    size_t next_relative = 0;
+    for (size_t i = 0; i < count; i++) {
+        DecodedInstruction &instr = decoded.code[i];
+        if (!is_branch(instr.op)) continue;
+        bool is_relative = next_relative < relative.size() && relative[next_relative] == i;
+        uint32_t end = i + 1 < count ? decoded.offsets[i + 1] : code_size;
+        int64_t target = is_relative ? static_cast<int64_t>(end) + instr.operand
+                                     : static_cast<int64_t>(static_cast<uint32_t>(instr.operand));
+        next_relative += is_relative;
+        if (target < 0 || target >= code_size || index_at[target] == UINT32_MAX) {
+            throw std::runtime_error("Branch at instruction " + std::to_string(i) + " targets invalid address " +
+                                     std::to_string(target));
+        }
+        instr.operand = static_cast<int32_t>(index_at[target]);
+    }
+    if (entry_address >= code_size || index_at[entry_address] == UINT32_MAX) {
+        throw std::runtime_error("Entry point outside the code section: " + std::to_string(entry_address));
+    }
+    decoded.entry = index_at[entry_address];
+    // Running off the end of the code hits this and traps like any invalid opcode.
+    decoded.code.push_back({END_OF_CODE, 0, 0});
+    decoded.offsets.push_back(code_size);
+    return decoded;
+}
+
+void write_pic_image(const std::string &path, const DecodedCode &decoded, const uint8_t *data, uint32_t data_size) {
+    uint64_t records = decoded.code.size();
+    uint64_t code_offset = STAK_PIC_PAGE_SIZE;
+    uint64_t addresses_offset = page_align(code_offset + records * STAK_PIC_RECORD_SIZE);
+    uint64_t data_offset = page_align(addresses_offset + records * 4);
+    uint64_t total = data_offset + data_size;
+    if (total > UINT32_MAX) {
+        throw std::runtime_error("Position-independent image exceeds 4 GiB.");
+    }
+
+    MappedFile out = MappedFile::create(path, total);
+    uint8_t *image = out.mutable_data();
+    write_u32(image, STAK_PIC_MAGIC);
+    write_u32(image + stak_pic::VERSION, STAK_PIC_VERSION);
+    write_u32(image + stak_pic::PAGE_SIZE, STAK_PIC_PAGE_SIZE);
+    write_u32(image + stak_pic::ENTRY, decoded.entry);
+    write_u32(image + stak_pic::CODE_OFFSET, static_cast<uint32_t>(code_offset));
+    write_u32(image + stak_pic::RECORD_COUNT, static_cast<uint32_t>(records));
+    write_u32(image + stak_pic::ADDRESSES_OFFSET, static_cast<uint32_t>(addresses_offset));
+    write_u32(image + stak_pic::DATA_OFFSET, static_cast<uint32_t>(data_offset));
+    write_u32(image + stak_pic::DATA_SIZE, data_size);
+
+    uint8_t *record = image + code_offset;
+    for (const DecodedInstruction &instr : decoded.code) {
+        record[0] = static_cast<uint8_t>(instr.op);
+        record[1] = instr.num_args;
+        write_u32(record + 4, static_cast<uint32_t>(instr.operand));
+        record += STAK_PIC_RECORD_SIZE;
+    }
+    for (uint64_t i = 0; i < records; i++) {
+        write_u32(image + addresses_offset + i * 4, decoded.offsets[i]);
+    }
+    if (data_size > 0) {
+        std::memcpy(image + data_offset, data, data_size);
+    }
+}
@@ -0,0 +1,75 @@
+// File: stak_image.h
+// Owner: Team
+// Role: Executable Format
+// Description: Decoding of STAK code into fixed-size instruction records, and the
+//              position-independent image (linker --pic) that stores those records
+//              directly, so the VM can map an executable and run it in place.
+
+#ifndef STAK_IMAGE_H
+#define STAK_IMAGE_H
+
+#include "opcodes.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Opcode byte 0 is never assigned; the decoder appends it after the last instruction.
+constexpr Opcode END_OF_CODE = static_cast<Opcode>(0);
+
+// A PIC image is a header page followed by three segments, each starting on a
+// page boundary. All header fields are little-endian u32:
+//
+//   magic STAK_PIC_MAGIC, version, page size, entry (an instruction index),
+//   code offset, record count (including the END_OF_CODE sentinel),
+//   addresses offset, data offset, data size
+//
+//   code       8-byte records laid out like DecodedInstruction: opcode, argument
+//              count, two zero bytes, then the operand as a little-endian i32.
+//              Branch operands are instruction indices from the start of the
+//              segment, so nothing in the image depends on where it is mapped.
+//   addresses  u32 per record: its byte offset in the classic STAK code
+//              section, the address --symbols files and reports use.
+//   data       the data section, unchanged; addressed from the segment base.
+constexpr uint32_t STAK_PIC_MAGIC = 0x53544B50; // "STKP"
+constexpr uint32_t STAK_PIC_VERSION = 1;
+constexpr uint32_t STAK_PIC_PAGE_SIZE = 4096;
+constexpr uint32_t STAK_PIC_RECORD_SIZE = 8;
+
+// Records are used in place wherever DecodedInstruction has exactly their layout.
+constexpr bool STAK_PIC_IN_PLACE = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ &&
+                                   sizeof(DecodedInstruction) == STAK_PIC_RECORD_SIZE &&
+                                   offsetof(DecodedInstruction, num_args) == 1 &&
+                                   offsetof(DecodedInstruction, operand) == 4;
+
+// Byte offsets of the header fields.
+namespace stak_pic {
+constexpr uint32_t VERSION = 4;
+constexpr uint32_t PAGE_SIZE = 8;
+constexpr uint32_t ENTRY = 12;
+constexpr uint32_t CODE_OFFSET = 16;
+constexpr uint32_t RECORD_COUNT = 20;
+constexpr uint32_t ADDRESSES_OFFSET = 24;
+constexpr uint32_t DATA_OFFSET = 28;
+constexpr uint32_t DATA_SIZE = 32;
+} // namespace stak_pic
+
+// A classic code section decoded to long-form records.
+struct DecodedCode
+{
+    std::vector<DecodedInstruction> code; // Ends with an END_OF_CODE sentinel.
+    std::vector<uint32_t> offsets;        // Byte offset of each record; the sentinel's is the code size.
+    uint32_t entry = 0;                   // Instruction index of the entry point.
+};
+
+// Decodes `code_size` bytes of STAK code. Branch targets, relative or absolute,
+// become instruction indices. Throws std::runtime_error, naming `path`, on
+// invalid opcodes, branches to addresses that are not instruction boundaries,
+// or an entry address outside the code.
+DecodedCode decode_code(const uint8_t *code, uint32_t code_size, uint32_t entry_address, const std::string &path);
+
+// Writes a PIC image holding `decoded` and the data section.
+// Throws std::runtime_error if it cannot be written.
+void write_pic_image(const std::string &path, const DecodedCode &decoded, const uint8_t *data, uint32_t data_size);
+
+#endif // STAK_IMAGE_H
@@ -0,0 +1,88 @@
+// File: stats.cpp
+// Owner: Team
+// Role: Assembler Instrumentation
+// Description: Implementation of the phase timers and resource queries.
+
+#include "stats.h"
+#include <mutex>
+#include <sys/resource.h>
+#include <time.h>
+
+thread_local AllocationCounters thread_allocations = {false, 0, 0};
+
+static double clock_seconds(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+const char *phase_name(Phase phase) {
+    static const char *const names[PHASE_COUNT] = {
+        "parse", "globals", "fixups", "optimize", "verify", "layout", "code", "stitch", "write"
+    };
+    return names[static_cast<size_t>(phase)];
+}
+
+PhaseCounters AssemblyStats::total() const {
+    PhaseCounters sum;
+    for (const PhaseCounters &p : phases) {
+        sum.wall_seconds += p.wall_seconds;
+        sum.cpu_seconds += p.cpu_seconds;
+        sum.allocations += p.allocations;
+        sum.allocated_bytes += p.allocated_bytes;
+    }
+    return sum;
+}
+
+void AssemblyStats::merge(const AssemblyStats &other) {
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        phases[i].wall_seconds += other.phases[i].wall_seconds;
+        phases[i].cpu_seconds += other.phases[i].cpu_seconds;
+        phases[i].allocations += other.phases[i].allocations;
+        phases[i].allocated_bytes += other.phases[i].allocated_bytes;
+    }
+    lines += other.lines;
+    source_bytes += other.source_bytes;
+}
+
+void PhaseTimer::start() {
+    allocations_start = thread_allocations;
+    thread_allocations.enabled = true;
+    wall_start = clock_seconds(CLOCK_MONOTONIC);
+    cpu_start = clock_seconds(CLOCK_THREAD_CPUTIME_ID);
+}
+
+void PhaseTimer::finish() {
+    PhaseCounters &counters = (*stats)[phase];
+    counters.wall_seconds += clock_seconds(CLOCK_MONOTONIC) - wall_start;
+    counters.cpu_seconds += clock_seconds(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+    counters.allocations += thread_allocations.count - allocations_start.count;
+    counters.allocated_bytes += thread_allocations.bytes - allocations_start.bytes;
+    thread_allocations.enabled = allocations_start.enabled;
+}
+
+void TaskTimer::start() {
+    allocations_start = thread_allocations;
+    thread_allocations.enabled = true;
+    cpu_start = clock_seconds(CLOCK_THREAD_CPUTIME_ID);
+}
+
+void TaskTimer::finish() {
+    double cpu_seconds = clock_seconds(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+    uint64_t allocations = thread_allocations.count - allocations_start.count;
+    uint64_t allocated_bytes = thread_allocations.bytes - allocations_start.bytes;
+    thread_allocations.enabled = allocations_start.enabled;
+
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    PhaseCounters &counters = (*stats)[phase];
+    counters.cpu_seconds += cpu_seconds;
+    counters.allocations += allocations;
+    counters.allocated_bytes += allocated_bytes;
+}
+
+long peak_rss_kb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // Kilobytes on Linux.
+}
@@ -0,0 +1,120 @@
+// File: stats.h
+// Owner: Team
+// Role: Assembler Instrumentation
+// Description: Per-phase wall time, CPU time and heap allocation counters for
+//              the assembler's --stats mode. Every hook is a no-op on a null
+//              AssemblyStats pointer, so runs without --stats pay nothing.
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Assembly phases in pipeline order. The parser reads the source in a single
+// pass, so symbol collection and instruction parsing are one phase.
+enum class Phase
+{
+    PARSE,    // Read lines, define symbols, parse instructions and data.
+    GLOBALS,  // Apply .global directives.
+    FIXUPS,   // Resolve forward references.
+    OPTIMIZE, // -O peephole pass.
+    VERIFY,   // --verify stack-depth analysis.
+    LAYOUT,   // Size every section and allocate the object file.
+    CODE,     // Header, code section and relocation entries.
+    STITCH,   // Data section and symbol table.
+    WRITE     // Write the object file to disk.
+};
+constexpr size_t PHASE_COUNT = 9;
+
+const char *phase_name(Phase phase);
+
+struct PhaseCounters
+{
+    double wall_seconds = 0;
+    double cpu_seconds = 0;       // Summed over the caller and any pool threads it used.
+    uint64_t allocations = 0;     // operator new calls, on the same threads.
+    uint64_t allocated_bytes = 0;
+};
+
+struct AssemblyStats
+{
+    PhaseCounters phases[PHASE_COUNT];
+    uint64_t lines = 0;           // Source lines read.
+    uint64_t source_bytes = 0;
+
+    PhaseCounters &operator[](Phase phase) { return phases[static_cast<size_t>(phase)]; }
+    const PhaseCounters &operator[](Phase phase) const { return phases[static_cast<size_t>(phase)]; }
+    PhaseCounters total() const;
+    void merge(const AssemblyStats &other);
+};
+
+// Heap allocations made by the current thread while `enabled` is set. The
+// counting operator new lives in alloc_hook.cpp and is linked into the
+// assembler and the validator only; without it these stay zero.
+struct AllocationCounters
+{
+    bool enabled;
+    uint64_t count;
+    uint64_t bytes;
+};
+extern thread_local AllocationCounters thread_allocations;
+
+// Charges the time and allocations between construction and stop() (or
+// destruction) to one phase. Does nothing when `stats` is null.
+class PhaseTimer {
+public:
+    PhaseTimer(AssemblyStats *stats, Phase phase) : stats(stats), phase(phase) {
+        if (stats) start();
+    }
+    ~PhaseTimer() { stop(); }
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+    void stop() {
+        if (stats) finish();
+        stats = nullptr;
+    }
+
+private:
+    void start();
+    void finish();
+
+    AssemblyStats *stats;
+    Phase phase;
+    double wall_start = 0;
+    double cpu_start = 0;
+    AllocationCounters allocations_start{};
+};
+
+// Charges the CPU time and allocations of one task run on a pool thread to a
+// phase; concurrent tasks may charge the same phase. Wall time stays with the
+// caller's PhaseTimer, which covers the wait for the tasks. Does nothing when
+// `stats` is null or when a PhaseTimer already counts this thread, as it does
+// for a task run inline.
+class TaskTimer {
+public:
+    TaskTimer(AssemblyStats *stats, Phase phase)
+        : stats(stats && !thread_allocations.enabled ? stats : nullptr), phase(phase) {
+        if (this->stats) start();
+    }
+    ~TaskTimer() {
+        if (stats) finish();
+    }
+    TaskTimer(const TaskTimer &) = delete;
+    TaskTimer &operator=(const TaskTimer &) = delete;
+
+private:
+    void start();
+    void finish();
+
+    AssemblyStats *stats;
+    Phase phase;
+    double cpu_start = 0;
+    AllocationCounters allocations_start{};
+};
+
+// Peak resident set size of the process so far, in kilobytes.
+long peak_rss_kb();
+
+#endif // STATS_H
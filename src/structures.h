@@ -1,116 +1,73 @@
 // File: structures.h
 // Owner: Rashmitha
 // Role: Data Structures for Assembler & Linker
-// Description: Defines the core C++ data structures for all instructions, directives,
+// Description: Defines the core C++ data structures for the instruction stream, directives,
 //              and the components of a relocatable object file (.o).
 
 #ifndef STRUCTURES_H
 #define STRUCTURES_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <cstdint>
-#include <memory>
+#include "mapped_file.h"
+#include "opcodes.h"
+#include "symbol_table.h"
 
-// Represents a single symbol (label or variable).
-struct Symbol
+// A binary file included by .incbin. It stays mapped until the emitter copies
+// it into the object, so its contents are never buffered anywhere else.
+struct DataInclude
 {
-    enum class Type
-    {
-        TEXT,
-        DATA
-    };
-    enum class Binding
-    {
-        LOCAL,
-        GLOBAL
-    };
-
-    std::string name;
-    Type type;
-    Binding binding = Binding::LOCAL; // Symbols are local by default.
-    uint32_t address;                 // Address within its section.
+    uint32_t at; // Spliced in after this many bytes of DataSection::bytes.
+    std::shared_ptr<const MappedFile> file;
 };
 
-// Represents an entry in the data section.
-struct DataEntry
+// The data section of a unit. Initialized data comes first, in source order:
+// .static and .array values, kept as little-endian bytes, and .incbin files,
+// each padded to 4 bytes. The .space regions follow all of it, like a BSS;
+// they are only counted, and the object records their size instead of zeros.
+struct DataSection
 {
-    std::string name;
-    int32_t value;
+    std::vector<uint8_t> bytes;
+    std::vector<DataInclude> includes; // In source order.
+    uint32_t size = 0;                 // Initialized bytes: `bytes` plus every include.
+    uint32_t zero_size = 0;            // .space bytes after them.
+    size_t entries = 0;                // Data directives, for reports.
 };
 
 // Represents a relocation entry. Tells the linker where to patch an address.
 struct RelocationEntry
 {
-    uint32_t offset;           // Byte offset in the code section that needs patching.
-    std::string target_symbol; // The global symbol whose address should be patched in.
+    uint32_t offset;                    // Byte offset in the code section that needs patching.
+    SymbolId target_symbol = NO_SYMBOL; // The global symbol whose address should be patched in.
 };
 
-// A container for all the parsed information from a single .stkasm file.
-struct AssemblyUnit
+// A compact, column-oriented instruction list. Instruction i is opcodes[i] with
+// operands[i] (the iconst value, or the SymbolId of a jmp/invoke target) and
+// arg_counts[i] (the invoke argument count, 0 otherwise). Six bytes per
+// instruction, stored in three contiguous per-unit buffers.
+struct InstructionStream
 {
-    std::vector<std::unique_ptr<class Instruction>> instructions;
-    std::vector<DataEntry> data_entries;
-    std::vector<Symbol> symbol_table;
-};
+    std::vector<Opcode> opcodes;
+    std::vector<int32_t> operands;
+    std::vector<uint8_t> arg_counts;
 
-// Base class for all instructions
-class Instruction
-{
-public:
-    virtual ~Instruction() = default;
-    // The emit function now helps generate relocation entries.
-    virtual std::vector<uint8_t> emit(const AssemblyUnit &unit, RelocationEntry &reloc) const = 0;
+    void push(Opcode op, int32_t operand = 0, uint8_t num_args = 0)
+    {
+        opcodes.push_back(op);
+        operands.push_back(operand);
+        arg_counts.push_back(num_args);
+    }
+    size_t size() const { return opcodes.size(); }
 };
 
-// Instruction Classes (IConst, IAdd, ISub, IMul, IDiv, Ret, Jmp, Invoke)
-// ... class definitions are the same as in the previous response ...
-class IConst : public Instruction
-{
-public:
-    int32_t value;
-    explicit IConst(int32_t val) : value(val) {}
-    std::vector<uint8_t> emit(const AssemblyUnit &unit, RelocationEntry &reloc) const override;
-};
-class IAdd : public Instruction
-{
-public:
-    std::vector<uint8_t> emit(const AssemblyUnit &unit, RelocationEntry &reloc) const override;
-};
-class ISub : public Instruction
-{
-public:
-    std::vector<uint8_t> emit(const AssemblyUnit &unit, RelocationEntry &reloc) const override;
-};
-class IMul : public Instruction
-{
-public:
-    std::vector<uint8_t> emit(const AssemblyUnit &unit, RelocationEntry &reloc) const override;
-};
-class IDiv : public Instruction
-{
-public:
-    std::vector<uint8_t> emit(const AssemblyUnit &unit, RelocationEntry &reloc) const override;
-};
-class Ret : public Instruction
-{
-public:
-    std::vector<uint8_t> emit(const AssemblyUnit &unit, RelocationEntry &reloc) const override;
-};
-class Jmp : public Instruction
-{
-public:
-    std::string label;
-    explicit Jmp(const std::string &lbl) : label(lbl) {}
-    std::vector<uint8_t> emit(const AssemblyUnit &unit, RelocationEntry &reloc) const override;
-};
-class Invoke : public Instruction
+// A container for all the parsed information from a single .stkasm file.
+struct AssemblyUnit
 {
-public:
-    std::string label;
-    uint8_t num_args;
-    Invoke(const std::string &lbl, uint8_t args) : label(lbl), num_args(args) {}
-    std::vector<uint8_t> emit(const AssemblyUnit &unit, RelocationEntry &reloc) const override;
+    InstructionStream instructions;
+    DataSection data;
+    SymbolTable symbol_table;
 };
 
-#endif // STRUCTURES_H
\ No newline at end of file
+#endif // STRUCTURES_H
@@ -5,22 +5,70 @@
 
 #include "symbol_table.h"
 
-bool SymbolTable::add_label(const std::string& name, uint32_t address) {
-    if (table.count(name)) {
-        return false; // Symbol already exists
+// 32-bit FNV-1a over the symbol name.
+static uint32_t hash_name(std::string_view name) {
+    uint32_t h = 2166136261u;
+    for (unsigned char c : name) {
+        h ^= c;
+        h *= 16777619u;
     }
-    table[name] = {name, address, SymbolType::LABEL};
-    return true;
+    return h;
 }
 
-std::optional<uint32_t> SymbolTable::get_address(const std::string& name) const {
-    auto it = table.find(name);
-    if (it != table.end()) {
-        return it->second.address;
+SymbolId SymbolTable::add(std::string_view name, Symbol::Type type, uint32_t address) {
+    // Keep the load factor at or below 1/2 so probe sequences stay short.
+    if ((symbols.size() + 1) * 2 > slots.size()) {
+        rehash(slots.empty() ? 64 : slots.size() * 2);
     }
-    return std::nullopt; // Symbol not found
+
+    uint32_t h = hash_name(name);
+    size_t mask = slots.size() - 1;
+    size_t i = h & mask;
+    while (slots[i].id != NO_SYMBOL) {
+        if (slots[i].hash == h && this->name(slots[i].id) == name) {
+            return NO_SYMBOL; // Symbol already exists
+        }
+        i = (i + 1) & mask;
+    }
+
+    SymbolId id = static_cast<SymbolId>(symbols.size());
+    Symbol sym;
+    sym.name_offset = static_cast<uint32_t>(pool.size());
+    sym.name_length = static_cast<uint32_t>(name.size());
+    sym.type = type;
+    sym.address = address;
+    pool.append(name.data(), name.size());
+    symbols.push_back(sym);
+    slots[i] = {id, h};
+    return id;
+}
+
+SymbolId SymbolTable::find(std::string_view name) const {
+    if (slots.empty()) {
+        return NO_SYMBOL;
+    }
+    uint32_t h = hash_name(name);
+    size_t mask = slots.size() - 1;
+    for (size_t i = h & mask; slots[i].id != NO_SYMBOL; i = (i + 1) & mask) {
+        if (slots[i].hash == h && this->name(slots[i].id) == name) {
+            return slots[i].id;
+        }
+    }
+    return NO_SYMBOL; // Symbol not found
 }
 
-size_t SymbolTable::size() const {
-    return table.size();
+void SymbolTable::rehash(size_t capacity) {
+    std::vector<Slot> old(capacity);
+    old.swap(slots);
+    size_t mask = capacity - 1;
+    for (const Slot &slot : old) {
+        if (slot.id == NO_SYMBOL) {
+            continue;
+        }
+        size_t i = slot.hash & mask;
+        while (slots[i].id != NO_SYMBOL) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+    }
 }
@@ -1,48 +1,85 @@
 // File: symbol_table.h
 // Owner: Rashmitha
 // Role: Symbol Table Implementation
-// Description: Defines the interface for the Symbol Table module.
+// Description: Defines the interface for the Symbol Table module: an open-addressing
+//              hash table over an interned string pool, shared by the parser and emitter.
 
 #ifndef SYMBOL_TABLE_H
 #define SYMBOL_TABLE_H
 
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
 #include <cstdint>
-#include <optional> // Used for safely returning lookups
 
-// Defines the different types of symbols we might encounter.
-enum class SymbolType {
-    LABEL,
-    // Future types can be added here, e.g., DATA, GLOBAL_LABEL
-};
+// Symbols are referred to by their index in the table.
+using SymbolId = uint32_t;
+constexpr SymbolId NO_SYMBOL = 0xFFFFFFFF;
+
+// Represents a single symbol (label or variable).
+struct Symbol
+{
+    enum class Type
+    {
+        TEXT,
+        DATA,
+        EXTERN // Declared with .extern: referenced here, defined in another object.
+    };
+    enum class Binding
+    {
+        LOCAL,
+        GLOBAL
+    };
 
-// Represents a single entry in the symbol table.
-struct Symbol {
-    std::string name;
-    uint32_t address;
-    SymbolType type;
+    uint32_t name_offset;             // Start of the name in the table's string pool.
+    uint32_t name_length;
+    Type type;
+    Binding binding = Binding::LOCAL; // Symbols are local by default.
+    uint32_t address;                 // Address within its section.
 };
 
 // The SymbolTable class encapsulates all logic for managing symbols.
+// Symbols are kept in definition order; lookups go through a hash index.
 class SymbolTable {
 public:
-    // Tries to add a new label symbol. Returns false if the symbol already exists.
-    bool add_label(const std::string& name, uint32_t address);
+    // Tries to add a new symbol. Returns NO_SYMBOL if the name already exists.
+    SymbolId add(std::string_view name, Symbol::Type type, uint32_t address);
+
+    // Looks up a symbol by name. Returns NO_SYMBOL if not found.
+    SymbolId find(std::string_view name) const;
+
+    Symbol &operator[](SymbolId id) { return symbols[id]; }
+    const Symbol &operator[](SymbolId id) const { return symbols[id]; }
 
-    // Alias for adding symbols (future expansion).
-    inline bool add_symbol(const std::string& name, uint32_t address) {
-        return add_label(name, address);
+    // Returns the interned name. The view is invalidated by the next add().
+    std::string_view name(SymbolId id) const { return name(symbols[id]); }
+    std::string_view name(const Symbol &sym) const {
+        return std::string_view(pool.data() + sym.name_offset, sym.name_length);
     }
 
-    // Looks up a symbol's address by its name.
-    std::optional<uint32_t> get_address(const std::string& name) const;
+    // All names back to back, in definition order; each name appears once.
+    const std::string &string_pool() const { return pool; }
 
     // Returns the total number of symbols in the table.
-    size_t size() const;
+    size_t size() const { return symbols.size(); }
+
+    std::vector<Symbol>::const_iterator begin() const { return symbols.begin(); }
+    std::vector<Symbol>::const_iterator end() const { return symbols.end(); }
 
 private:
-    std::map<std::string, Symbol> table;
+    void rehash(size_t capacity);
+
+    // An index entry keeps the name's hash next to the id, so a probe only
+    // touches the symbol and its name when the hashes already match.
+    struct Slot
+    {
+        SymbolId id = NO_SYMBOL;  // NO_SYMBOL marks an empty slot.
+        uint32_t hash = 0;
+    };
+
+    std::string pool;             // All symbol names, back to back.
+    std::vector<Symbol> symbols;
+    std::vector<Slot> slots;      // Open-addressing index.
 };
 
 #endif // SYMBOL_TABLE_H
@@ -0,0 +1,131 @@
+// File: thread_pool.cpp
+// Owner: Team
+// Role: Concurrency Support
+// Description: Implementation of the work-stealing thread pool.
+
+#include "thread_pool.h"
+
+// Index of the pool worker running on this thread, or -1 for outside threads.
+static thread_local const ThreadPool *current_pool = nullptr;
+static thread_local int current_worker = -1;
+
+ThreadPool::ThreadPool(unsigned num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0) num_threads = 1;
+    }
+    for (unsigned i = 0; i < num_threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < num_threads; i++) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    unsigned target;
+    if (current_pool == this && current_worker >= 0) {
+        target = static_cast<unsigned>(current_worker);
+    } else {
+        target = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    }
+    {
+        // Count the task before it becomes visible, so a worker that takes it
+        // straight away never drops `queued` below zero. Under state_mutex so a
+        // worker about to sleep cannot miss it.
+        std::lock_guard<std::mutex> lock(state_mutex);
+        unfinished++;
+        queued.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    work_available.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(state_mutex);
+    all_done.wait(lock, [this] { return unfinished == 0; });
+    if (first_error) {
+        std::exception_ptr error = first_error;
+        first_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)> &body) {
+    for (size_t i = 0; i < count; i++) {
+        submit([&body, i] { body(i); });
+    }
+    wait();
+}
+
+// Own deque first (newest task, still warm in cache), then steal the oldest
+// task from the other workers, starting with the next one over.
+bool ThreadPool::try_take(unsigned index, std::function<void()> &task) {
+    {
+        Queue &own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < queues.size(); k++) {
+        Queue &victim = *queues[(index + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run_task(std::function<void()> &task) {
+    try {
+        task();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (!first_error) first_error = std::current_exception();
+    }
+    task = nullptr;
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (--unfinished == 0) {
+        all_done.notify_all();
+    }
+}
+
+void ThreadPool::worker_loop(unsigned index) {
+    current_pool = this;
+    current_worker = static_cast<int>(index);
+    std::function<void()> task;
+    for (;;) {
+        if (queued.load(std::memory_order_acquire) > 0 && try_take(index, task)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            run_task(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(state_mutex);
+        work_available.wait(lock, [this] {
+            return stopping || queued.load(std::memory_order_relaxed) > 0;
+        });
+        if (stopping && queued.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+    }
+}
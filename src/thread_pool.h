@@ -0,0 +1,66 @@
+// File: thread_pool.h
+// Owner: Team
+// Role: Concurrency Support
+// Description: A small work-stealing thread pool. Each worker owns a task deque;
+//              it pops its own work LIFO and steals from the other workers FIFO
+//              when it runs dry.
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // Starts `num_threads` workers; 0 means one per hardware thread.
+    explicit ThreadPool(unsigned num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Queues a task. Tasks submitted from a worker go to that worker's own deque.
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished. Rethrows the first
+    // exception a task raised, if any. Must not be called from inside a task.
+    void wait();
+
+    // Runs body(0) .. body(count - 1) on the pool and waits for all of them.
+    void parallel_for(size_t count, const std::function<void(size_t)> &body);
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void worker_loop(unsigned index);
+    bool try_take(unsigned index, std::function<void()> &task);
+    void run_task(std::function<void()> &task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex state_mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+    std::atomic<size_t> queued{0};   // Tasks submitted but not yet taken; counted before the push.
+    size_t unfinished = 0;           // Tasks submitted but not yet completed (guarded by state_mutex).
+    bool stopping = false;
+    std::atomic<unsigned> next_queue{0};
+    std::exception_ptr first_error;
+};
+
+#endif // THREAD_POOL_H
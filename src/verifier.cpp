@@ -0,0 +1,234 @@
+// File: verifier.cpp
+// Owner: Team
+// Role: Stack Verifier
+// Description: Abstract interpretation of operand-stack depth. Each function is
+//              walked block by block with depths relative to its entry depth;
+//              callees are analysed first (with an explicit work stack, so deep
+//              call chains cannot overflow the native stack) and summarised once.
+
+#include "verifier.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+// Net effect of a run of straight-line instructions, relative to the depth at its start.
+struct Block {
+    uint32_t end;  // Index of the jmp/invoke/ret (or other non-straight-line instruction) ending it.
+    int32_t low;   // Lowest depth any pop reaches (<= 0).
+    int32_t high;  // Highest depth any push reaches (>= 0).
+    int32_t net;   // Depth at `end`.
+};
+
+struct Summary {
+    enum class State { ACTIVE, DONE } state = State::ACTIVE;
+    int32_t low = 0;      // Relative to the entry depth.
+    int32_t high = 0;
+    int32_t total = 0;    // Including callee frames.
+    FunctionDepth::Exit exit = FunctionDepth::Exit::UNKNOWN;
+    int32_t ret_depth = 0;
+    bool recursive = false;
+};
+
+// One function being walked.
+struct Walk {
+    uint32_t entry;
+    uint32_t pc;
+    int32_t depth = 0;
+    int32_t low = 0;
+    int32_t high = 0;
+    int32_t total = 0;
+    bool recursive = false;
+    std::unordered_map<uint32_t, int32_t> arrivals; // jmp target -> depth on arrival.
+};
+
+struct InvokeSite {
+    uint32_t site;
+    uint32_t target;
+    uint8_t num_args;
+};
+
+class Verifier {
+public:
+    explicit Verifier(CodeView code) : code(code) {}
+
+    void run(uint32_t root) {
+        if (summaries.count(root)) return;
+        start(root);
+        while (!walks.empty()) {
+            step(walks.size() - 1);
+        }
+    }
+
+    StackVerification result() {
+        for (const InvokeSite &call : calls) {
+            const Summary &callee = summaries[call.target];
+            if (-callee.low > call.num_args) {
+                fail("invoke at instruction " + std::to_string(call.site) + " passes " +
+                     std::to_string(call.num_args) + " argument(s) to the function at " +
+                     std::to_string(call.target) + ", which pops " + std::to_string(-callee.low));
+            }
+        }
+        StackVerification verification;
+        verification.ok = error.empty();
+        verification.error = error;
+        for (const auto &entry : summaries) {
+            const Summary &s = entry.second;
+            FunctionDepth fn;
+            fn.entry = entry.first;
+            fn.min_args = static_cast<uint32_t>(-s.low);
+            fn.max_depth = static_cast<uint32_t>(s.high - s.low);
+            fn.max_total = static_cast<uint32_t>(s.total - s.low);
+            fn.exit = s.exit;
+            fn.returns_value = s.exit == FunctionDepth::Exit::RETURNS && s.ret_depth - s.low > 0;
+            fn.recursive = s.recursive;
+            verification.functions.push_back(fn);
+        }
+        std::sort(verification.functions.begin(), verification.functions.end(),
+                  [](const FunctionDepth &a, const FunctionDepth &b) { return a.entry < b.entry; });
+        return verification;
+    }
+
+private:
+    static bool straight_line(Opcode op) {
+        switch (op) {
+            case Opcode::ICONST:
+            case Opcode::IADD:
+            case Opcode::ISUB:
+            case Opcode::IMUL:
+            case Opcode::IDIV:
+            case Opcode::ICONST_IADD:
+            case Opcode::ICONST_ISUB:
+            case Opcode::ICONST_IMUL:
+            case Opcode::ICONST_IDIV:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    const Block &block_at(uint32_t start) {
+        auto found = blocks.find(start);
+        if (found != blocks.end()) return found->second;
+        Block block{start, 0, 0, 0};
+        while (block.end < code.size() && straight_line(code[block.end].op)) {
+            StackEffect effect = stack_effect(code[block.end].op);
+            block.low = std::min(block.low, block.net - effect.pops);
+            block.net += effect.pushes - effect.pops;
+            block.high = std::max(block.high, block.net);
+            block.end++;
+        }
+        return blocks.emplace(start, block).first->second;
+    }
+
+    void fail(const std::string &message) {
+        if (error.empty()) error = message;
+    }
+
+    void start(uint32_t entry) {
+        summaries[entry] = Summary();
+        Walk walk;
+        walk.entry = entry;
+        walk.pc = entry;
+        walks.push_back(std::move(walk));
+    }
+
+    void finish(size_t index, FunctionDepth::Exit exit) {
+        Walk &w = walks[index];
+        Summary &s = summaries[w.entry];
+        s.state = Summary::State::DONE;
+        s.low = w.low;
+        s.high = w.high;
+        s.total = std::max(w.total, w.high);
+        s.exit = exit;
+        s.ret_depth = w.depth;
+        s.recursive = w.recursive;
+        walks.pop_back();
+    }
+
+    // Advances the walk at `index` until it finishes or must wait for a callee.
+    void step(size_t index) {
+        for (;;) {
+            Walk &w = walks[index];
+            if (w.pc >= code.size()) return finish(index, FunctionDepth::Exit::UNKNOWN);
+            const Block &block = block_at(w.pc);
+            w.low = std::min(w.low, w.depth + block.low);
+            w.high = std::max(w.high, w.depth + block.high);
+            w.depth += block.net;
+            w.pc = block.end;
+            if (w.pc >= code.size()) return finish(index, FunctionDepth::Exit::UNKNOWN);
+
+            const DecodedInstruction &instr = code[w.pc];
+            switch (instr.op) {
+                case Opcode::RET:
+                    return finish(index, FunctionDepth::Exit::RETURNS);
+                case Opcode::JMP: {
+                    if (instr.operand == EXTERNAL_TARGET) return finish(index, FunctionDepth::Exit::UNKNOWN);
+                    uint32_t target = static_cast<uint32_t>(instr.operand);
+                    auto arrival = w.arrivals.emplace(target, w.depth);
+                    if (!arrival.second) {
+                        if (arrival.first->second != w.depth) {
+                            fail("inconsistent stack depth at instruction " + std::to_string(target) + ": reached at " +
+                                 std::to_string(arrival.first->second) + " and at " + std::to_string(w.depth) +
+                                 " relative to the entry of the function at " + std::to_string(w.entry));
+                        }
+                        return finish(index, FunctionDepth::Exit::NEVER); // An infinite loop.
+                    }
+                    w.pc = target;
+                    break;
+                }
+                case Opcode::INVOKE: {
+                    w.low = std::min(w.low, w.depth - instr.num_args);
+                    if (instr.operand == EXTERNAL_TARGET) return finish(index, FunctionDepth::Exit::UNKNOWN);
+                    uint32_t target = static_cast<uint32_t>(instr.operand);
+                    auto found = summaries.find(target);
+                    if (found == summaries.end()) {
+                        start(target); // Come back to this invoke once the callee is summarised.
+                        return;
+                    }
+                    const Summary &callee = found->second;
+                    calls.push_back({w.pc, target, instr.num_args});
+                    if (callee.state == Summary::State::ACTIVE) {
+                        // Without conditional branches a call back into an active function
+                        // can only recurse until the call stack overflows.
+                        w.recursive = true;
+                        return finish(index, FunctionDepth::Exit::NEVER);
+                    }
+                    // The callee's frame starts at our depth minus its arguments, which it sees at depth num_args.
+                    w.total = std::max(w.total, w.depth + callee.total);
+                    w.recursive = w.recursive || callee.recursive;
+                    if (callee.exit != FunctionDepth::Exit::RETURNS) return finish(index, callee.exit);
+                    bool has_value = instr.num_args + callee.ret_depth > 0;
+                    w.depth += (has_value ? 1 : 0) - instr.num_args;
+                    w.pc++;
+                    break;
+                }
+                default:
+                    return finish(index, FunctionDepth::Exit::NEVER); // Traps: invalid opcode or end of code.
+            }
+        }
+    }
+
+    CodeView code;
+    std::unordered_map<uint32_t, Block> blocks;
+    std::unordered_map<uint32_t, Summary> summaries;
+    std::vector<Walk> walks;
+    std::vector<InvokeSite> calls;
+    std::string error;
+};
+
+} // namespace
+
+StackVerification verify_stack(CodeView code, const std::vector<uint32_t> &roots) {
+    Verifier verifier(code);
+    for (uint32_t root : roots) {
+        verifier.run(root);
+    }
+    return verifier.result();
+}
+
+const FunctionDepth *find_function(const StackVerification &verification, uint32_t entry) {
+    auto it = std::lower_bound(verification.functions.begin(), verification.functions.end(), entry,
+                               [](const FunctionDepth &fn, uint32_t value) { return fn.entry < value; });
+    return it != verification.functions.end() && it->entry == entry ? &*it : nullptr;
+}
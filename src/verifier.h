@@ -0,0 +1,58 @@
+// File: verifier.h
+// Owner: Team
+// Role: Stack Verifier
+// Description: Static operand-stack analysis. Proves, per function, how many
+//              arguments it pops and how high its stack grows, and rejects code
+//              that underflows or reaches a jmp target at different depths.
+
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include "opcodes.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Branch operand for a target resolved only by the linker (an .extern or a
+// global defined elsewhere). Paths through such a branch cannot be followed.
+constexpr int32_t EXTERNAL_TARGET = -1;
+
+// What the verifier proved about one function, i.e. an invoke target or a root.
+// Depths are counted from the function's frame base with min_args arguments.
+struct FunctionDepth
+{
+    enum class Exit
+    {
+        RETURNS, // Reaches ret.
+        NEVER,   // Loops forever, recurses forever or traps.
+        UNKNOWN  // Leaves the code being verified (external call or jump, end of code).
+    };
+
+    uint32_t entry = 0;
+    uint32_t min_args = 0;  // Values it needs on entry so that no pop underflows.
+    uint32_t max_depth = 0; // Highest depth of its own frame.
+    uint32_t max_total = 0; // Highest depth counting the frames of its callees too.
+    Exit exit = Exit::UNKNOWN;
+    bool returns_value = false; // With min_args arguments; only for RETURNS.
+    bool recursive = false;     // Can reach itself again, so max_total is not a bound.
+};
+
+struct StackVerification
+{
+    bool ok = true;
+    std::string error; // First problem found, when !ok.
+    std::vector<FunctionDepth> functions; // Every function analysed, by entry address.
+};
+
+// Analyses every function reachable from `roots` by abstract interpretation
+// over basic blocks (split at jmp targets and after jmp/invoke/ret). Branch
+// operands are instruction indices or EXTERNAL_TARGET. Code has no conditional
+// branches, so each function is one path through its blocks; a block reached
+// again must be reached at the same depth, and an invoke must pass at least
+// as many arguments as its callee's min_args.
+StackVerification verify_stack(CodeView code, const std::vector<uint32_t> &roots);
+
+// Looks up a function in a verification result; nullptr if it was not analysed.
+const FunctionDepth *find_function(const StackVerification &verification, uint32_t entry);
+
+#endif // VERIFIER_H
@@ -0,0 +1,440 @@
+// File: vm.cpp
+// Owner: Team
+// Role: Virtual Machine
+// Description: STAK loader and the two interpreter loops (computed-goto and switch).
+//              Operand and call stacks live in storage allocated once per run.
+
+#include "vm.h"
+#include "byte_io.h"
+#include "jit.h"
+#include "linker.h"
+#include "mapped_file.h"
+#include "profiler.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+// Checks a PIC image and points `program` into its mapping. Every field is
+// bounds-checked and every record validated, so the interpreter can trust the
+// records exactly as it trusts freshly decoded ones; nothing is written.
+static void map_pic_image(Program &program, const std::string &path) {
+    const uint8_t *image = program.image.data();
+    size_t size = program.image.size();
+    ByteReader header(image, size, path);
+    header.u32(); // magic
+    uint32_t version = header.u32();
+    uint32_t page_size = header.u32();
+    if (version != STAK_PIC_VERSION || page_size != STAK_PIC_PAGE_SIZE) {
+        throw std::runtime_error("Unsupported position-independent image version in " + path);
+    }
+    uint32_t entry = header.u32();
+    uint32_t code_offset = header.u32();
+    uint32_t count = header.u32();
+    uint32_t addresses_offset = header.u32();
+    uint32_t data_offset = header.u32();
+    uint32_t data_size = header.u32();
+    auto segment = [&](uint32_t offset, uint64_t length) {
+        if (offset % STAK_PIC_PAGE_SIZE != 0 || offset + length > size) {
+            throw std::runtime_error("Segment outside the image in " + path);
+        }
+        return image + offset;
+    };
+    const uint8_t *records = segment(code_offset, static_cast<uint64_t>(count) * STAK_PIC_RECORD_SIZE);
+    const uint8_t *addresses = segment(addresses_offset, static_cast<uint64_t>(count) * 4);
+    program.data = segment(data_offset, data_size);
+    program.data_size = data_size;
+    if (count == 0 || records[(count - 1) * STAK_PIC_RECORD_SIZE] != static_cast<uint8_t>(END_OF_CODE)) {
+        throw std::runtime_error("Code segment does not end with the end-of-code record in " + path);
+    }
+    if (entry >= count - 1) {
+        throw std::runtime_error("Entry point outside the code section: " + std::to_string(entry));
+    }
+
+    for (uint32_t i = 0; i + 1 < count; i++) {
+        const uint8_t *record = records + static_cast<size_t>(i) * STAK_PIC_RECORD_SIZE;
+        Opcode op = static_cast<Opcode>(record[0]);
+        if (encoded_size(op) == 0 || long_form(op) != op || (op != Opcode::INVOKE && record[1] != 0)) {
+            throw std::runtime_error("Invalid instruction record " + std::to_string(i) + " in " + path);
+        }
+        uint32_t target = read_u32(record + 4);
+        if (is_branch(op) && target >= count - 1) {
+            throw std::runtime_error("Branch at instruction " + std::to_string(i) + " targets invalid address " +
+                                     std::to_string(target));
+        }
+    }
+    program.entry = entry;
+    if (STAK_PIC_IN_PLACE) {
+        program.code = CodeView(reinterpret_cast<const DecodedInstruction *>(records), count);
+        program.offsets = reinterpret_cast<const uint32_t *>(addresses);
+        return;
+    }
+    // A big-endian host reads the records into memory instead.
+    DecodedCode &decoded = program.decoded;
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t *record = records + static_cast<size_t>(i) * STAK_PIC_RECORD_SIZE;
+        decoded.code.push_back({static_cast<Opcode>(record[0]), record[1], static_cast<int32_t>(read_u32(record + 4))});
+        decoded.offsets.push_back(read_u32(addresses + static_cast<size_t>(i) * 4));
+    }
+    program.code = decoded.code;
+    program.offsets = decoded.offsets.data();
+}
+
+Program load_program(const std::string &path) {
+    Program program;
+    program.image = MappedFile::open_read(path);
+    ByteReader header(program.image.data(), program.image.size(), path);
+    uint32_t magic = header.u32();
+    if (magic == STAK_PIC_MAGIC) {
+        map_pic_image(program, path);
+        return program;
+    }
+    if (magic != STAK_MAGIC) {
+        throw std::runtime_error("Not a STAK executable: " + path);
+    }
+    uint32_t entry_address = header.u32();
+    uint32_t code_size = header.u32();
+    uint32_t data_size = header.u32();
+    const uint8_t *code = header.bytes(code_size);
+    program.data = header.bytes(data_size);
+    program.data_size = data_size;
+
+    program.decoded = decode_code(code, code_size, entry_address, path);
+    program.code = program.decoded.code;
+    program.offsets = program.decoded.offsets.data();
+    program.entry = program.decoded.entry;
+    return program;
+}
+
+StackVerification verify_program(Program &program) {
+    program.verified = false;
+    StackVerification verification = verify_stack(program.code, {program.entry});
+    const FunctionDepth *root = find_function(verification, program.entry);
+    if (verification.ok && root->min_args > 0) {
+        verification.ok = false;
+        verification.error = "the entry function pops " + std::to_string(root->min_args) +
+                             " value(s) from an empty stack";
+    }
+    if (verification.ok && !root->recursive) {
+        program.verified = true;
+        program.max_stack_depth = root->max_total;
+    }
+    return verification;
+}
+
+namespace {
+
+struct Frame
+{
+    const DecodedInstruction *return_ip; // nullptr for the entry frame
+    int32_t *base;                       // Operand stack position of the first argument
+};
+
+[[noreturn]] void trap(const char *what, const Program &program, const DecodedInstruction *ip) {
+    if (ip->op == END_OF_CODE) {
+        what = "Execution ran past the end of the code";
+    }
+    throw std::runtime_error(std::string(what) + " at instruction " + std::to_string(ip - program.code.data()));
+}
+
+// Per-run machine state; the stacks are sized once up front.
+struct Machine
+{
+    std::vector<int32_t> stack;
+    std::vector<Frame> frames;
+    int32_t *stack_end;
+    Frame *frames_end;
+    std::unique_ptr<JitCompiler> jit; // Null when the JIT is off or unsupported.
+    uint64_t jit_calls = 0;
+    Profiler *profiler;
+
+    Machine(const Program &program, const VmOptions &options, size_t stack_size)
+        : stack(stack_size), frames(options.max_call_depth), profiler(options.profiler) {
+        stack_end = stack.data() + stack.size();
+        frames_end = frames.data() + frames.size();
+        if (profiler) {
+            profiler->start(); // Native code would run uncounted, so the JIT stays off.
+        } else if (options.jit != JitMode::OFF && JitCompiler::supported()) {
+            uint32_t threshold = options.jit == JitMode::ALWAYS ? 1 : options.jit_threshold;
+            jit = std::make_unique<JitCompiler>(program, threshold);
+        }
+    }
+
+    VmResult finish(VmResult result, uint64_t executed, bool unchecked) const {
+        result.executed = executed;
+        result.unchecked = unchecked;
+        result.jit_compiled = jit ? jit->compiled() : 0;
+        result.jit_calls = jit_calls;
+        return result;
+    }
+};
+
+// Performs an invoke on the native tier when its target is compiled and the
+// whole call stays within the operand stack; the interpreter handles the rest,
+// including every stack trap. The callee's ret is applied here.
+bool invoke_native(Machine &m, const Program &program, const DecodedInstruction *ip, int32_t *&sp,
+                   uint64_t &executed) {
+    const JitFunction *fn = m.jit->on_invoke(static_cast<uint32_t>(ip->operand));
+    if (!fn || fn->min_depth < -static_cast<int32_t>(ip->num_args) || fn->max_depth > m.stack_end - sp) {
+        return false;
+    }
+    uint32_t status = fn->entry(sp);
+    if (status != 0) {
+        trap("Division by zero", program, program.code.data() + (status - 1));
+    }
+    executed += fn->length;
+    m.jit_calls++;
+    int32_t *base = sp - ip->num_args;
+    int32_t *top = sp + fn->ret_depth;
+    if (top > base) {
+        *base = top[-1];
+        sp = base + 1;
+    } else {
+        sp = base;
+    }
+    return true;
+}
+
+} // namespace
+
+// The two loops below implement identical semantics; they differ only in how
+// control moves to the next handler. The stack/frame checks are the same.
+// Each is instantiated without operand-stack checks for verified programs,
+// whose stack is allocated at exactly the proven depth, and with the profiler
+// hooks only when a run is profiled.
+#define CHECK_PUSH(n) if (Checked && sp + (n) > m.stack_end) trap("Operand stack overflow", program, ip)
+#define CHECK_POP(n) if (Checked && sp - (n) < fp->base) trap("Operand stack underflow", program, ip)
+
+#if defined(__GNUC__)
+template <bool Checked, bool Profiled>
+static VmResult run_threaded(const Program &program, const VmOptions &options, size_t stack_size) {
+    void *handlers[256];
+    for (void *&handler : handlers) handler = &&op_invalid;
+    handlers[static_cast<uint8_t>(Opcode::ICONST)] = &&op_iconst;
+    handlers[static_cast<uint8_t>(Opcode::IADD)] = &&op_iadd;
+    handlers[static_cast<uint8_t>(Opcode::ISUB)] = &&op_isub;
+    handlers[static_cast<uint8_t>(Opcode::IMUL)] = &&op_imul;
+    handlers[static_cast<uint8_t>(Opcode::IDIV)] = &&op_idiv;
+    handlers[static_cast<uint8_t>(Opcode::RET)] = &&op_ret;
+    handlers[static_cast<uint8_t>(Opcode::JMP)] = &&op_jmp;
+    handlers[static_cast<uint8_t>(Opcode::INVOKE)] = &&op_invoke;
+    handlers[static_cast<uint8_t>(Opcode::ICONST_IADD)] = &&op_iconst_iadd;
+    handlers[static_cast<uint8_t>(Opcode::ICONST_ISUB)] = &&op_iconst_isub;
+    handlers[static_cast<uint8_t>(Opcode::ICONST_IMUL)] = &&op_iconst_imul;
+    handlers[static_cast<uint8_t>(Opcode::ICONST_IDIV)] = &&op_iconst_idiv;
+
+    Machine m(program, options, stack_size);
+    VmResult result;
+    const DecodedInstruction *code = program.code.data();
+    const DecodedInstruction *ip = code + program.entry;
+    int32_t *sp = m.stack.data();
+    Frame *fp = m.frames.data();
+    *fp = {nullptr, sp};
+    uint64_t executed = 0;
+
+#define DISPATCH() do { \
+        executed++; \
+        if (Profiled) m.profiler->on_instruction(ip); \
+        goto *handlers[static_cast<uint8_t>(ip->op)]; \
+    } while (0)
+#define NEXT() do { ip++; DISPATCH(); } while (0)
+
+    DISPATCH();
+
+op_iconst:
+    CHECK_PUSH(1);
+    *sp++ = ip->operand;
+    NEXT();
+op_iadd:
+    CHECK_POP(2);
+    sp--; sp[-1] = wrap_add(sp[-1], sp[0]);
+    NEXT();
+op_isub:
+    CHECK_POP(2);
+    sp--; sp[-1] = wrap_sub(sp[-1], sp[0]);
+    NEXT();
+op_imul:
+    CHECK_POP(2);
+    sp--; sp[-1] = wrap_mul(sp[-1], sp[0]);
+    NEXT();
+op_idiv:
+    CHECK_POP(2);
+    if (sp[-1] == 0) trap("Division by zero", program, ip);
+    sp--; sp[-1] = wrap_div(sp[-1], sp[0]);
+    NEXT();
+op_iconst_iadd:
+    CHECK_POP(1);
+    sp[-1] = wrap_add(sp[-1], ip->operand);
+    NEXT();
+op_iconst_isub:
+    CHECK_POP(1);
+    sp[-1] = wrap_sub(sp[-1], ip->operand);
+    NEXT();
+op_iconst_imul:
+    CHECK_POP(1);
+    sp[-1] = wrap_mul(sp[-1], ip->operand);
+    NEXT();
+op_iconst_idiv:
+    CHECK_POP(1);
+    if (ip->operand == 0) trap("Division by zero", program, ip);
+    sp[-1] = wrap_div(sp[-1], ip->operand);
+    NEXT();
+op_jmp:
+    ip = code + ip->operand;
+    DISPATCH();
+op_invoke:
+    CHECK_POP(ip->num_args);
+    if (fp + 1 == m.frames_end) trap("Call stack overflow", program, ip);
+    if (m.jit && invoke_native(m, program, ip, sp, executed)) NEXT();
+    if (Profiled) m.profiler->on_invoke(static_cast<uint32_t>(ip->operand));
+    ++fp;
+    *fp = {ip + 1, sp - ip->num_args};
+    ip = code + ip->operand;
+    DISPATCH();
+op_ret: {
+    // The top value, if the function left any, replaces the frame's arguments.
+    bool has_value = sp > fp->base;
+    int32_t value = has_value ? sp[-1] : 0;
+    sp = fp->base;
+    if (has_value) *sp++ = value;
+    if (fp->return_ip == nullptr) {
+        result.has_value = has_value;
+        result.value = value;
+        return m.finish(result, executed, !Checked);
+    }
+    if (Profiled) m.profiler->on_return();
+    ip = fp->return_ip;
+    fp--;
+    DISPATCH();
+}
+op_invalid:
+    trap("Invalid opcode", program, ip);
+
+#undef NEXT
+#undef DISPATCH
+}
+#endif
+
+template <bool Checked, bool Profiled>
+static VmResult run_switch(const Program &program, const VmOptions &options, size_t stack_size) {
+    Machine m(program, options, stack_size);
+    VmResult result;
+    const DecodedInstruction *code = program.code.data();
+    const DecodedInstruction *ip = code + program.entry;
+    int32_t *sp = m.stack.data();
+    Frame *fp = m.frames.data();
+    *fp = {nullptr, sp};
+    uint64_t executed = 0;
+
+    for (;;) {
+        executed++;
+        if (Profiled) m.profiler->on_instruction(ip);
+        switch (ip->op) {
+            case Opcode::ICONST:
+                CHECK_PUSH(1);
+                *sp++ = ip->operand;
+                ip++;
+                break;
+            case Opcode::IADD:
+                CHECK_POP(2);
+                sp--; sp[-1] = wrap_add(sp[-1], sp[0]);
+                ip++;
+                break;
+            case Opcode::ISUB:
+                CHECK_POP(2);
+                sp--; sp[-1] = wrap_sub(sp[-1], sp[0]);
+                ip++;
+                break;
+            case Opcode::IMUL:
+                CHECK_POP(2);
+                sp--; sp[-1] = wrap_mul(sp[-1], sp[0]);
+                ip++;
+                break;
+            case Opcode::IDIV:
+                CHECK_POP(2);
+                if (sp[-1] == 0) trap("Division by zero", program, ip);
+                sp--; sp[-1] = wrap_div(sp[-1], sp[0]);
+                ip++;
+                break;
+            case Opcode::ICONST_IADD:
+                CHECK_POP(1);
+                sp[-1] = wrap_add(sp[-1], ip->operand);
+                ip++;
+                break;
+            case Opcode::ICONST_ISUB:
+                CHECK_POP(1);
+                sp[-1] = wrap_sub(sp[-1], ip->operand);
+                ip++;
+                break;
+            case Opcode::ICONST_IMUL:
+                CHECK_POP(1);
+                sp[-1] = wrap_mul(sp[-1], ip->operand);
+                ip++;
+                break;
+            case Opcode::ICONST_IDIV:
+                CHECK_POP(1);
+                if (ip->operand == 0) trap("Division by zero", program, ip);
+                sp[-1] = wrap_div(sp[-1], ip->operand);
+                ip++;
+                break;
+            case Opcode::JMP:
+                ip = code + ip->operand;
+                break;
+            case Opcode::INVOKE:
+                CHECK_POP(ip->num_args);
+                if (fp + 1 == m.frames_end) trap("Call stack overflow", program, ip);
+                if (m.jit && invoke_native(m, program, ip, sp, executed)) {
+                    ip++;
+                    break;
+                }
+                if (Profiled) m.profiler->on_invoke(static_cast<uint32_t>(ip->operand));
+                ++fp;
+                *fp = {ip + 1, sp - ip->num_args};
+                ip = code + ip->operand;
+                break;
+            case Opcode::RET: {
+                bool has_value = sp > fp->base;
+                int32_t value = has_value ? sp[-1] : 0;
+                sp = fp->base;
+                if (has_value) *sp++ = value;
+                if (fp->return_ip == nullptr) {
+                    result.has_value = has_value;
+                    result.value = value;
+                    return m.finish(result, executed, !Checked);
+                }
+                if (Profiled) m.profiler->on_return();
+                ip = fp->return_ip;
+                fp--;
+                break;
+            }
+            default:
+                trap("Invalid opcode", program, ip);
+        }
+    }
+}
+
+#undef CHECK_POP
+#undef CHECK_PUSH
+
+template <bool Checked, bool Profiled>
+static VmResult run_loop(const Program &program, const VmOptions &options, size_t stack_size) {
+#if defined(__GNUC__)
+    if (options.dispatch == Dispatch::THREADED) {
+        return run_threaded<Checked, Profiled>(program, options, stack_size);
+    }
+#endif
+    return run_switch<Checked, Profiled>(program, options, stack_size);
+}
+
+VmResult run_program(const Program &program, const VmOptions &options) {
+    if (options.stack_size == 0 || options.max_call_depth == 0) {
+        throw std::runtime_error("Stack sizes must be positive.");
+    }
+    bool checked = !(options.trust_verifier && program.verified && program.max_stack_depth <= options.stack_size);
+    size_t stack_size = checked ? options.stack_size : std::max<size_t>(program.max_stack_depth, 1);
+    if (options.profiler) {
+        return checked ? run_loop<true, true>(program, options, stack_size)
+                       : run_loop<false, true>(program, options, stack_size);
+    }
+    return checked ? run_loop<true, false>(program, options, stack_size)
+                   : run_loop<false, false>(program, options, stack_size);
+}
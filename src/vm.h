@@ -0,0 +1,95 @@
+// File: vm.h
+// Owner: Team
+// Role: Virtual Machine
+// Description: Loader and interpreter for linked STAK executables (.vm).
+
+#ifndef VM_H
+#define VM_H
+
+#include "mapped_file.h"
+#include "opcodes.h"
+#include "stak_image.h"
+#include "verifier.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Profiler;
+
+// Instructions are decoded once at load time, so the dispatch loop never
+// touches the variable-length byte encoding. A position-independent image
+// already holds the decoded records, and runs from its read-only mapping.
+struct Program
+{
+    CodeView code;                     // Ends with an END_OF_CODE sentinel.
+    const uint32_t *offsets = nullptr; // Byte address of each entry of `code`, for reports.
+    const uint8_t *data = nullptr;
+    uint32_t data_size = 0;
+    uint32_t entry = 0; // Instruction index of the entry point.
+
+    // Set by verify_program when every reachable path is proven free of stack
+    // underflow and the whole run fits in max_stack_depth values.
+    bool verified = false;
+    uint32_t max_stack_depth = 0;
+
+    // What the views above point into: the mapped executable, plus the decoded
+    // code when it could not be used in place.
+    MappedFile image;
+    DecodedCode decoded;
+};
+
+enum class Dispatch
+{
+    THREADED, // Computed goto (GCC/Clang); falls back to SWITCH elsewhere.
+    SWITCH
+};
+
+enum class JitMode
+{
+    OFF,    // Interpret everything.
+    ON,     // Compile functions once they are invoked jit_threshold times.
+    ALWAYS  // Compile every function on its first invoke.
+};
+
+struct VmOptions
+{
+    size_t stack_size = 1 << 20;     // Operand stack capacity, in values.
+    size_t max_call_depth = 1 << 16; // Call stack capacity, in frames.
+    Dispatch dispatch = Dispatch::THREADED;
+    JitMode jit = JitMode::ON;       // Ignored where the JIT is unsupported.
+    uint32_t jit_threshold = 64;     // Invocations before a function is compiled.
+    bool trust_verifier = true;      // Run verified programs without operand-stack checks.
+    Profiler *profiler = nullptr;    // Records the run when set; the JIT is off while profiling.
+};
+
+struct VmResult
+{
+    bool has_value = false;  // Whether the entry function returned a value.
+    int32_t value = 0;
+    uint64_t executed = 0;   // Instructions executed, on either tier.
+    size_t jit_compiled = 0; // Functions compiled to native code.
+    uint64_t jit_calls = 0;  // Invokes that ran native code.
+    bool unchecked = false;  // Ran without operand-stack checks, on a stack of exactly max_stack_depth.
+};
+
+// Loads a STAK executable: a classic one is decoded, a position-independent
+// one (linker --pic) is mapped and checked but neither copied nor patched.
+// Throws std::runtime_error if the file is malformed, including branches to
+// addresses outside the code.
+Program load_program(const std::string &path);
+
+// Verifies the operand-stack use of everything reachable from the entry point.
+// When no path underflows and no call recursion makes the depth unbounded,
+// marks the program verified with the proven max_stack_depth. A program that
+// fails is still runnable; it just keeps every stack check.
+StackVerification verify_program(Program &program);
+
+// Runs the program from its entry point until the entry function returns.
+// Throws std::runtime_error on a trap (division by zero, stack over/underflow);
+// compiled functions trap exactly where the interpreter would. A verified
+// program whose max depth fits in options.stack_size runs without stack checks
+// (unless options.trust_verifier is false): it cannot overflow or underflow.
+VmResult run_program(const Program &program, const VmOptions &options = {});
+
+#endif // VM_H
@@ -0,0 +1,94 @@
+// File: workload.cpp
+// Owner: Team
+// Role: Benchmarking Support
+// Description: Implementation of the synthetic workload generator.
+
+#include "workload.h"
+#include <vector>
+
+namespace {
+
+// splitmix64: tiny, fast and identical everywhere, unlike std:: distributions.
+class Random {
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    // Uniform in [0, 1).
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    // Uniform in [0, n); n must be positive.
+    size_t below(size_t n) { return static_cast<size_t>(next() % n); }
+    bool chance(double p) { return unit() < p; }
+
+private:
+    uint64_t state;
+};
+
+} // namespace
+
+std::string generate_workload(const WorkloadShape &shape) {
+    Random rng(shape.seed);
+    const size_t n = shape.instructions;
+
+    // Decide up front where every label goes, so branches can refer forward.
+    // Label 0 ("main") sits on the first instruction.
+    std::vector<size_t> label_at; // Instruction index of each label, ascending.
+    label_at.push_back(0);
+    for (size_t i = 1; i < n; i++) {
+        if (rng.chance(shape.label_density)) {
+            label_at.push_back(i);
+        }
+    }
+
+    std::string out;
+    out.reserve(n * 14 + shape.data_entries * 24);
+    if (shape.data_entries > 0) {
+        out += ".data\n";
+        for (size_t d = 0; d < shape.data_entries; d++) {
+            out += "    .static v" + std::to_string(d) + " " + std::to_string(static_cast<int32_t>(rng.next())) + "\n";
+        }
+    }
+    out += ".text\n.global main\n";
+    for (size_t l = 1; l < label_at.size(); l++) {
+        if (rng.chance(shape.global_ratio)) {
+            out += ".global L" + std::to_string(l) + "\n";
+        }
+    }
+
+    static const char *const arithmetic[] = {"iadd", "isub", "imul", "idiv"};
+    size_t next_label = 0; // First label not yet defined.
+    for (size_t i = 0; i < n; i++) {
+        while (next_label < label_at.size() && label_at[next_label] == i) {
+            out += next_label == 0 ? std::string("main") : "L" + std::to_string(next_label);
+            out += ":\n";
+            next_label++;
+        }
+
+        if (rng.chance(shape.branch_ratio)) {
+            // Defined labels are [0, next_label), never empty here; forward ones are the rest.
+            bool forward = next_label < label_at.size() && rng.chance(shape.forward_ratio);
+            size_t target = forward ? next_label + rng.below(label_at.size() - next_label)
+                                    : rng.below(next_label);
+            std::string name = target == 0 ? std::string("main") : "L" + std::to_string(target);
+            if (rng.chance(0.5)) {
+                out += "    jmp " + name + "\n";
+            } else {
+                out += "    invoke " + name + " " + std::to_string(rng.below(4)) + "\n";
+            }
+        } else if (i + 1 == n || rng.chance(0.02)) {
+            out += "    ret\n";
+        } else if (rng.chance(0.5)) {
+            out += "    iconst " + std::to_string(static_cast<int32_t>(rng.next() % 2001) - 1000) + "\n";
+        } else {
+            out += "    ";
+            out += arithmetic[rng.below(4)];
+            out += "\n";
+        }
+    }
+    return out;
+}
@@ -0,0 +1,30 @@
+// File: workload.h
+// Owner: Team
+// Role: Benchmarking Support
+// Description: Deterministic generator of synthetic .stkasm programs with a
+//              configurable size and shape, for benchmarks and stress tests.
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// The knobs of a generated program. Ratios are in [0, 1].
+struct WorkloadShape
+{
+    size_t instructions = 100000;
+    double label_density = 0.05;  // Labels per instruction.
+    double branch_ratio = 0.10;   // Fraction of instructions that are jmp/invoke.
+    double forward_ratio = 0.5;   // Fraction of branches whose label is defined later.
+    double global_ratio = 0.1;    // Fraction of labels exported with .global.
+    size_t data_entries = 100;    // .static entries in the .data section.
+    uint64_t seed = 1;
+};
+
+// Generates a program that assembles without errors. The same shape always
+// yields the same text, on every platform.
+std::string generate_workload(const WorkloadShape &shape);
+
+#endif // WORKLOAD_H
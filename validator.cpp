@@ -1,53 +1,330 @@
 // File: validator.cpp
 // Owner: Person A
 // Role: Validator
-// Description: C++ script to test the parser against all files in the tests/ directory.
+// Description: Regression runner for every .stkasm case under tests/ (recursively). Cases
+//              run in parallel; each is parsed and emitted, and the object bytes are
+//              compared with the golden file <case>.golden. An optional sidecar
+//              <case>.expect holds `key = value` lines:
+//                  error = <message>     the case must fail with exactly this error
+//                  time_ms = <number>    budget for parse + emit wall time (best of --repeat)
+//                  allocations = <n>     budget for heap allocations during parse + emit
+//              Only a case with `error` is expected to fail. Every case is also
+//              parsed split into chunks of a few lines, as large files are, and must
+//              give the same object or error. --update rewrites the golden files,
+//              refreshes the error of expected failures and fills in missing budgets
+//              from the measured costs.
+//              Usage: validator [-j N] [--repeat N] [--update] [--json FILE] [tests_dir]
 
 #include "parser.h"
+#include "arg_parse.h"
+#include "emitter.h"
 #include "structures.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <filesystem> // Requires C++17
 
 namespace fs = std::filesystem;
 
-int main() {
-    std::cout << "--- Running C++ Parser Validator ---" << std::endl;
+// New budgets leave this much headroom over the measured cost.
+constexpr double TIME_HEADROOM = 10.0;
+constexpr double MIN_TIME_BUDGET_MS = 5.0;
+constexpr double ALLOCATION_HEADROOM = 1.5;
+// Small enough that every case spans several chunks.
+constexpr size_t SPLIT_CHUNK_BYTES = 48;
+
+struct Expectation {
+    bool has_error = false;
+    std::string error;
+    double time_ms = -1;    // Negative: no budget.
+    long long allocations = -1;
+};
+
+struct CaseResult {
+    fs::path path;
+    bool passed = false;
+    std::string message;
+    double time_ms = 0;
+    uint64_t allocations = 0;
+    size_t instructions = 0, symbols = 0, data_entries = 0, bytes = 0;
+};
+
+static std::string trim(const std::string &s) {
+    size_t first = s.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+}
+
+static fs::path sidecar(const fs::path &source, const char *extension) {
+    fs::path path = source;
+    return path.replace_extension(extension);
+}
+
+// Reads <case>.expect; a missing file means no expectations. Throws on malformed lines.
+static Expectation read_expectation(const fs::path &source) {
+    Expectation expect;
+    std::ifstream in(sidecar(source, ".expect"));
+    std::string line;
+    while (std::getline(in, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            throw std::runtime_error("Malformed line in " + sidecar(source, ".expect").string() + ": " + line);
+        }
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        if (key == "error") {
+            expect.has_error = true;
+            expect.error = value;
+        } else if (key == "time_ms") {
+            expect.time_ms = std::stod(value);
+        } else if (key == "allocations") {
+            expect.allocations = std::stoll(value);
+        } else {
+            throw std::runtime_error("Unknown key '" + key + "' in " + sidecar(source, ".expect").string());
+        }
+    }
+    return expect;
+}
+
+static void write_expectation(const fs::path &source, const Expectation &expect) {
+    std::ofstream out(sidecar(source, ".expect"));
+    if (expect.has_error) out << "error = " << expect.error << "\n";
+    out << "time_ms = " << expect.time_ms << "\n";
+    out << "allocations = " << expect.allocations << "\n";
+}
+
+static bool read_bytes(const fs::path &path, std::vector<uint8_t> &bytes) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Assembles the case again through parse_buffer_parallel and the ranged emitter;
+// returns a failure message if the object or error differs from the single pass.
+static std::string check_split(const fs::path &path, bool threw, const std::string &error,
+                               const std::vector<uint8_t> &object) {
+    std::ifstream in(path, std::ios::binary);
+    std::string source((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ThreadPool pool(2);
+    std::vector<uint8_t> split_object;
+    std::string split_error;
+    try {
+        AssemblyUnit unit = parse_buffer_parallel(source, pool, nullptr, SPLIT_CHUNK_BYTES, path.string());
+        split_object = emit_object_file(unit, nullptr, &pool);
+    } catch (const std::runtime_error &e) {
+        split_error = e.what();
+        if (!threw || split_error != error) {
+            return "Split parse raised '" + split_error + "'" + (threw ? " instead of '" + error + "'" : "");
+        }
+        return "";
+    }
+    if (threw) {
+        return "Split parse did not raise '" + error + "'";
+    }
+    if (split_object != object) {
+        return "Split parse emitted different bytes (" + std::to_string(split_object.size()) + " vs " +
+               std::to_string(object.size()) + ").";
+    }
+    return "";
+}
+
+// Parses and emits one case `repeat` times, keeping the fastest run's costs.
+static CaseResult run_case(const fs::path &path, unsigned repeat, bool update) {
+    CaseResult result;
+    result.path = path;
+    Expectation expect;
+    try {
+        expect = read_expectation(path);
+    } catch (const std::exception &e) {
+        result.message = e.what();
+        return result;
+    }
+    bool should_fail = expect.has_error;
+
+    std::vector<uint8_t> object;
+    std::string error;
+    bool threw = false;
+    for (unsigned run = 0; run < repeat; run++) {
+        AssemblyStats stats;
+        try {
+            AssemblyUnit unit = parse_file(path.string(), &stats);
+            object = emit_object_file(unit, &stats);
+            result.instructions = unit.instructions.size();
+            result.symbols = unit.symbol_table.size();
+            result.data_entries = unit.data.entries;
+            result.bytes = object.size();
+        } catch (const std::runtime_error &e) {
+            threw = true;
+            error = e.what();
+        }
+        PhaseCounters total = stats.total();
+        if (run == 0 || total.wall_seconds * 1e3 < result.time_ms) {
+            result.time_ms = total.wall_seconds * 1e3;
+            result.allocations = total.allocations;
+        }
+    }
+
+    if (update) {
+        if (!threw) {
+            std::ofstream out(sidecar(path, ".golden"), std::ios::binary);
+            out.write(reinterpret_cast<const char *>(object.data()), static_cast<std::streamsize>(object.size()));
+        }
+        if (expect.time_ms < 0) {
+            expect.time_ms = std::max(MIN_TIME_BUDGET_MS, std::ceil(result.time_ms * TIME_HEADROOM));
+        }
+        if (expect.allocations < 0) {
+            expect.allocations = static_cast<long long>(std::ceil(result.allocations * ALLOCATION_HEADROOM)) + 16;
+        }
+        if (threw && should_fail) {
+            expect.has_error = true;
+            expect.error = error;
+        }
+        write_expectation(path, expect);
+    }
+
+    if (threw != should_fail) {
+        result.message = threw ? "Valid file raised an unexpected error: " + error
+                               : "Invalid file was assembled without errors.";
+        return result;
+    }
+    if (threw && expect.has_error && error != expect.error) {
+        result.message = "Expected error '" + expect.error + "' but got '" + error + "'";
+        return result;
+    }
+    result.message = check_split(path, threw, error, object);
+    if (!result.message.empty()) {
+        return result;
+    }
+    if (!threw) {
+        std::vector<uint8_t> golden;
+        if (!read_bytes(sidecar(path, ".golden"), golden)) {
+            result.message = "No golden file " + sidecar(path, ".golden").string() + " (run validator --update).";
+            return result;
+        }
+        if (golden != object) {
+            auto diff = std::mismatch(golden.begin(), golden.end(), object.begin(), object.end());
+            result.message = "Emitted " + std::to_string(object.size()) + " bytes differ from the " +
+                             std::to_string(golden.size()) + "-byte golden file at offset " +
+                             std::to_string(diff.first - golden.begin()) + ".";
+            return result;
+        }
+    }
+    if (expect.time_ms >= 0 && result.time_ms > expect.time_ms) {
+        std::ostringstream message;
+        message << "Took " << result.time_ms << " ms; the budget is " << expect.time_ms << " ms.";
+        result.message = message.str();
+        return result;
+    }
+    if (expect.allocations >= 0 && result.allocations > static_cast<uint64_t>(expect.allocations)) {
+        result.message = "Made " + std::to_string(result.allocations) + " allocations; the budget is " +
+                         std::to_string(expect.allocations) + ".";
+        return result;
+    }
+    result.passed = true;
+    result.message = threw ? "Invalid file correctly raised an error: " + error : "";
+    return result;
+}
+
+static void write_json(const std::string &path, const std::vector<CaseResult> &results) {
+    std::FILE *out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return;
+    }
+    std::fprintf(out, "[\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const CaseResult &r = results[i];
+        std::fprintf(out, "  {\"case\": \"%s\", \"passed\": %s, \"time_ms\": %.4f, \"allocations\": %llu, \"bytes\": %zu}%s\n",
+                     r.path.generic_string().c_str(), r.passed ? "true" : "false", r.time_ms,
+                     static_cast<unsigned long long>(r.allocations), r.bytes, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "]\n");
+    std::fclose(out);
+}
+
+static void print_usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [-j N] [--repeat N] [--update] [--json FILE] [tests_dir]" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
     std::string tests_dir = "tests";
+    std::string json_path;
+    unsigned jobs = 0;
+    unsigned repeat = 3;
+    bool update = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-j" || arg == "--repeat" || arg == "--json") && i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        bool valid = true; // Cleared by a count that does not parse.
+        if (arg == "-j") {
+            valid = parse_number(argv[++i], jobs);
+        } else if (arg == "--repeat") {
+            valid = parse_number(argv[++i], repeat);
+            repeat = std::max(1u, repeat);
+        } else if (arg == "--json") {
+            json_path = argv[++i];
+        } else if (arg == "--update") {
+            update = true;
+        } else {
+            tests_dir = arg;
+        }
+        if (!valid) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::cout << "--- Running C++ Validator ---" << std::endl;
+    std::vector<fs::path> cases;
+    for (const auto &entry : fs::recursive_directory_iterator(tests_dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".stkasm") {
+            cases.push_back(entry.path());
+        }
+    }
+    std::sort(cases.begin(), cases.end()); // Report in a stable order whatever the scheduling.
+
+    std::vector<CaseResult> results(cases.size());
+    {
+        ThreadPool pool(jobs);
+        pool.parallel_for(cases.size(), [&](size_t i) { results[i] = run_case(cases[i], repeat, update); });
+    }
+
     int failed_count = 0;
+    double total_ms = 0;
+    for (const CaseResult &r : results) {
+        total_ms += r.time_ms;
+        std::cout << "--> Testing '" << r.path.string() << "' (" << r.time_ms << " ms, " << r.allocations
+                  << " allocations)..." << std::endl;
+        if (!r.passed) {
+            std::cout << "    \x1B[31mFAILED: " << r.message << "\x1B[0m" << std::endl;
+            failed_count++;
+        } else if (!r.message.empty()) {
+            std::cout << "    \x1B[32mPASSED: " << r.message << "\x1B[0m" << std::endl;
+        } else {
+            std::cout << "    \x1B[32mPASSED: Parsed " << r.instructions << " instructions, " << r.symbols
+                      << " symbols, " << r.data_entries << " data entries; emitted " << r.bytes
+                      << " bytes matching the golden file.\x1B[0m" << std::endl;
+        }
+    }
+    if (!json_path.empty()) {
+        write_json(json_path, results);
+    }
 
-    for (const auto& entry : fs::directory_iterator(tests_dir)) {
-        const auto& path = entry.path();
-        if (path.extension() == ".stkasm") {
-            std::cout << "--> Testing '" << path.string() << "'..." << std::endl;
-            bool should_fail = path.filename().string().find("invalid") != std::string::npos;
-
-            try {
-                AssemblyUnit result = parse_file(path.string());
-                if (should_fail) {
-                    std::cout << "    \x1B[31mFAILED: Invalid file was parsed without errors.\x1B[0m" << std::endl;
-                    failed_count++;
-                } else {
-                    std::cout << "    \x1B[32mPASSED: Parsed "
-                              << result.instructions.size() << " instructions, "
-                              << result.symbol_table.size() << " symbols, "
-                              << result.data_entries.size() << " data entries.\x1B[0m"
-                              << std::endl;
-                }
-            } catch (const std::runtime_error& e) {
-                if (should_fail) {
-                    std::cout << "    \x1B[32mPASSED: Invalid file correctly raised an error: "
-                              << e.what() << "\x1B[0m" << std::endl;
-                } else {
-                    std::cout << "    \x1B[31mFAILED: Valid file raised an unexpected error: "
-                              << e.what() << "\x1B[0m" << std::endl;
-                    failed_count++;
-                }
-            }
-        }
-    }
-
-    std::cout << "--- Validator Finished ---" << std::endl;
+    std::cout << "--- Validator Finished: " << results.size() - failed_count << " of " << results.size()
+              << " cases passed, " << total_ms << " ms of parse + emit"
+              << (update ? "; golden files and budgets updated" : "") << " ---" << std::endl;
     return failed_count; // 0 = success, >0 = failures
 }
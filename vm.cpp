@@ -0,0 +1,206 @@
+// File: vm.cpp
+// Owner: Team
+// Role: Virtual Machine Command-Line Tool
+// Description: Runs a linked .vm executable, or benchmarks the interpreter's dispatch loops.
+//              Usage: vm [options] program.vm
+
+#include "vm.h"
+#include "arg_parse.h"
+#include "profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+static void print_usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [options] <program.vm>" << std::endl;
+    std::cerr << "  --dispatch=threaded|switch  interpreter loop (default: threaded)" << std::endl;
+    std::cerr << "  --stack-size N              operand stack capacity in values" << std::endl;
+    std::cerr << "  --call-depth N              call stack capacity in frames" << std::endl;
+    std::cerr << "  --jit=off|on|always         compile hot functions to native code (default: on)" << std::endl;
+    std::cerr << "  --jit-threshold N           invocations before a function is compiled (default: 64)" << std::endl;
+    std::cerr << "  --jit-stats                 report what the JIT compiled" << std::endl;
+    std::cerr << "  --no-verify                 skip load-time stack verification and check every push and pop" << std::endl;
+    std::cerr << "  --verify-stats              report the proven stack depth of each function" << std::endl;
+    std::cerr << "  --bench N                   run N times with each dispatch loop, JIT off, and report ops/sec" << std::endl;
+    std::cerr << "  --profile PREFIX            count instructions per opcode, function and invoke edge; write" << std::endl;
+    std::cerr << "                              PREFIX.folded (flamegraph.pl input) and PREFIX.json" << std::endl;
+    std::cerr << "  --profile-period N          with --profile, record one in every N instructions" << std::endl;
+    std::cerr << "  --symbols FILE              names for the profile (default: <program.vm>.sym, from" << std::endl;
+    std::cerr << "                              linker --symbols)" << std::endl;
+}
+
+static std::FILE *open_report(const std::string &path) {
+    std::FILE *out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        std::cerr << "Cannot write " << path << std::endl;
+    }
+    return out;
+}
+
+// Writes PREFIX.folded and PREFIX.json; returns false if either cannot be written.
+static bool write_profile(const Profiler &profiler, const std::string &prefix, const std::vector<ProfileSymbol> &symbols) {
+    std::FILE *folded = open_report(prefix + ".folded");
+    if (!folded) return false;
+    profiler.write_folded(folded, symbols);
+    std::fclose(folded);
+    std::FILE *json = open_report(prefix + ".json");
+    if (!json) return false;
+    profiler.write_json(json, symbols);
+    std::fclose(json);
+    return true;
+}
+
+// Runs the program `iterations` times and returns dispatched instructions per second.
+// The JIT and profiler stay off so both loops interpret every instruction they count.
+static double measure(const Program &program, VmOptions options, Dispatch dispatch, unsigned iterations,
+                      uint64_t &executed) {
+    options.dispatch = dispatch;
+    options.jit = JitMode::OFF;
+    options.profiler = nullptr;
+    executed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < iterations; i++) {
+        executed += run_program(program, options).executed;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds > 0 ? executed / seconds : 0;
+}
+
+int main(int argc, char* argv[]) {
+    VmOptions options;
+    unsigned bench_iterations = 0;
+    bool jit_stats = false;
+    bool verify = true;
+    bool verify_stats = false;
+    std::string profile_prefix;
+    uint32_t profile_period = 1;
+    std::string symbols_path;
+    std::string path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool valid = true; // Cleared by a numeric flag whose value does not parse.
+        if ((arg == "--stack-size" || arg == "--call-depth" || arg == "--bench" || arg == "--jit-threshold" ||
+             arg == "--profile" || arg == "--profile-period" || arg == "--symbols") &&
+            i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (arg == "--dispatch=threaded") {
+            options.dispatch = Dispatch::THREADED;
+        } else if (arg == "--dispatch=switch") {
+            options.dispatch = Dispatch::SWITCH;
+        } else if (arg == "--jit=off") {
+            options.jit = JitMode::OFF;
+        } else if (arg == "--jit=on") {
+            options.jit = JitMode::ON;
+        } else if (arg == "--jit=always") {
+            options.jit = JitMode::ALWAYS;
+        } else if (arg == "--jit-threshold") {
+            valid = parse_number(argv[++i], options.jit_threshold);
+        } else if (arg == "--jit-stats") {
+            jit_stats = true;
+        } else if (arg == "--no-verify") {
+            verify = false;
+        } else if (arg == "--verify-stats") {
+            verify_stats = true;
+        } else if (arg == "--stack-size") {
+            valid = parse_number(argv[++i], options.stack_size);
+        } else if (arg == "--call-depth") {
+            valid = parse_number(argv[++i], options.max_call_depth);
+        } else if (arg == "--bench") {
+            valid = parse_number(argv[++i], bench_iterations);
+        } else if (arg == "--profile") {
+            profile_prefix = argv[++i];
+        } else if (arg == "--profile-period") {
+            valid = parse_number(argv[++i], profile_period);
+        } else if (arg == "--symbols") {
+            symbols_path = argv[++i];
+        } else if (!arg.empty() && arg[0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            path = arg;
+        }
+        if (!valid) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        Program program = load_program(path);
+        if (verify) {
+            StackVerification verification = verify_program(program);
+            if (!verification.ok) {
+                throw std::runtime_error("Stack verification failed: " + verification.error);
+            }
+            if (verify_stats) {
+                for (const FunctionDepth &fn : verification.functions) {
+                    std::printf("function @%u: %u argument(s), max depth %u, %u including callees%s\n", fn.entry,
+                                fn.min_args, fn.max_depth, fn.max_total, fn.recursive ? " (recursive)" : "");
+                }
+                if (program.verified) {
+                    std::printf("verified: stack of %u value(s), no per-op stack checks\n", program.max_stack_depth);
+                } else {
+                    std::printf("not verified: recursion makes the stack depth unbounded\n");
+                }
+            }
+        }
+        if (bench_iterations > 0) {
+            uint64_t executed = 0;
+            double threaded = measure(program, options, Dispatch::THREADED, bench_iterations, executed);
+            double switched = measure(program, options, Dispatch::SWITCH, bench_iterations, executed);
+            std::printf("Executed %llu instructions per loop.\n", static_cast<unsigned long long>(executed));
+            std::printf("threaded dispatch: %.1f M ops/sec\n", threaded / 1e6);
+            std::printf("switch dispatch:   %.1f M ops/sec\n", switched / 1e6);
+            if (switched > 0) {
+                std::printf("speedup:           %.2fx\n", threaded / switched);
+            }
+            return 0;
+        }
+
+        // A run that traps still writes its profile, up to the trap.
+        std::unique_ptr<Profiler> profiler;
+        std::vector<ProfileSymbol> symbols;
+        if (!profile_prefix.empty()) {
+            symbols = read_symbol_file(symbols_path.empty() ? path + ".sym" : symbols_path);
+            profiler = std::make_unique<Profiler>(program, profile_period);
+            options.profiler = profiler.get();
+        }
+        VmResult result;
+        try {
+            result = run_program(program, options);
+        } catch (const std::runtime_error &) {
+            if (profiler) write_profile(*profiler, profile_prefix, symbols);
+            throw;
+        }
+        if (profiler) {
+            if (!write_profile(*profiler, profile_prefix, symbols)) return 1;
+            std::cout << "Profile: " << profiler->samples() << " of " << result.executed
+                      << " instructions recorded -> " << profile_prefix << ".folded, " << profile_prefix
+                      << ".json" << (symbols.empty() ? " (no symbols; link with --symbols to name functions)" : "")
+                      << std::endl;
+        }
+        if (result.has_value) {
+            std::cout << "Result: " << result.value << std::endl;
+        } else {
+            std::cout << "Result: (none)" << std::endl;
+        }
+        if (jit_stats) {
+            std::cout << "JIT: compiled " << result.jit_compiled << " functions; " << result.jit_calls
+                      << " native calls; " << result.executed << " instructions executed." << std::endl;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "❌ VM error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}